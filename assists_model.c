@@ -17,7 +17,34 @@
  *   - Potential assists (uses LAST 5 games avg potential + LAST 5 conversion)
  */
 
+#define _GNU_SOURCE              /* mmap/madvise flags and truncate() under -std=c11 */
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* MAP_POPULATE and the madvise() hints only help; where a platform lacks
+ * them the mappings work the same without. */
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0
+#endif
+
+/* The batch kernels are bit-identical to project() only if no build fuses
+ * a*b+c into an FMA behind our back (e.g. -march=native with FMA). */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
 
 /*======================== TUNABLE WEIGHTS & CAPS ========================*/
 
@@ -46,15 +73,55 @@ static const double LEAGUE_AVG_AST_ALLOWED    = 25.0;   /* opponent AST allowed
 static const double MULT_MIN = 0.70;
 static const double MULT_MAX = 1.40;
 
+/* Team made-FG pool for the correlated teammate simulation */
+static const double PTS_PER_FGM   = 2.70;   /* team points per made FG, free throws included */
+static const double TEAM_FG_PCT   = 0.475;
+static const double MAX_AST_RATE  = 0.90;   /* share of makes the players' projections may claim */
+
+/* Team assist budget for --normalize, and how far it may move a player */
+static const double TEAM_AST_RATE   = 0.62;  /* assisted share of made FGs */
+static const double NORM_FLOOR_LINE = 0.75;  /* never cut a player below 75% of the line */
+static const double NORM_CAP_LINE   = 1.50;  /* never leave a player above 150% of the line */
+
+/* Spread of actual assists around the projection, for P(over/under/push):
+ * negative binomial with Var = mean + DISPERSION * mean^2 (0 = Poisson). */
+static const double DISPERSION = 0.05;
+
+/* Weight profiles: complete weight sets frozen at compile time. Each one
+ * gets its own batch kernel (see PROFILE KERNELS) with the weights folded
+ * in as constants, so disabled factors vanish from the generated code.
+ * "default" is exactly the constants above. To add a profile, add a row. */
+typedef struct {
+    double base_line, base_season;
+    double home_away, game_total, team_total, def_ast, pace;
+    double recent, minutes, b2b, potential;
+    double mult_min, mult_max;
+} Weights;
+
+/*  name     base_line  base_season  home  game  team  def   pace  recent minutes b2b  potential  min   max */
+#define WEIGHT_PROFILES(X) \
+    X(default, W_BASE_LINE, W_BASE_SEASON_AVG, W_HOME_AWAY, W_GAME_TOTAL, W_TEAM_TOTAL,              \
+               W_DEF_AST_ALLOWED, W_PACE, W_RECENT_FORM, W_MINUTES_TREND, W_BACK_TO_BACK,           \
+               W_POTENTIAL_AST, MULT_MIN, MULT_MAX)                                                  \
+    X(market,  0.70, 0.30,  0.03, 0.05, 0.10, 0.12, 0.06,  0.00, 0.00, 0.03, 0.00,  0.80, 1.25)     \
+    X(usage,   0.45, 0.55,  0.02, 0.03, 0.08, 0.10, 0.05,  0.10, 0.14, 0.03, 0.18,  0.65, 1.50)
+
 /*======================== HELPERS ========================*/
 static double clamp(double x, double lo, double hi) {
     return x < lo ? lo : (x > hi ? hi : x);
 }
 
+static int has_suffix(const char *s, const char *suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
 /*======================== INPUTS / OUTPUTS ========================*/
 typedef struct {
     /* Core */
     const char *player_name;
+    uint32_t player_id;          /* dense id in the slate's name table */
+    uint32_t team_id;            /* team's id in the same table, or STRTAB_NONE */
     double line_ast;             /* Sportsbook assists line */
     double season_avg_ast;       /* Season assists average */
 
@@ -92,6 +159,11 @@ typedef struct {
     double uncapped_multiplier;
     double final_multiplier;
     double projection;
+
+    /* Against line_ast, with actual assists ~ NB(projection, dispersion) */
+    double p_over;
+    double p_under;
+    double p_push;
 } Output;
 
 /*======================== MODEL FUNCTIONS ========================*/
@@ -153,6 +225,55 @@ static double m_potential_assists(const Inputs *in) {
     return 1.0 + rel * W_POTENTIAL_AST;
 }
 
+/* Dispersion used for the line probabilities; --dispersion overrides it. */
+static double line_dispersion = DISPERSION;
+
+#define LINE_KMAX 1000           /* CDF summation stops here */
+
+/* CDF of the assist distribution, negative binomial with mean mu and
+ * dispersion alpha (Poisson when alpha is 0), at each of the nk ascending
+ * whole numbers k[]. Assists are whole numbers, so the CDF is summed term by
+ * term through
+ *   pmf(j) = pmf(j-1) * (j-1 + 1/alpha)/j * alpha*mu/(1 + alpha*mu)
+ * (mu/j for Poisson). The sum is exact. It costs one exp, plus one step per
+ * assist up to the last point, however many points are asked for. */
+static void assist_cdf(double mu, double alpha, const double *k, int nk, double *cdf) {
+    if (mu < 0.0) mu = 0.0;
+    double pmf, q, r = 0.0;
+    if (alpha > 0.0) {
+        r = 1.0 / alpha;
+        pmf = exp(-r * log1p(alpha * mu));
+        q = alpha * mu / (1.0 + alpha * mu);
+    } else {
+        pmf = exp(-mu);
+        q = mu;
+    }
+    double c = 0.0;
+    int j = -1;
+    for (int t = 0; t < nk; ++t) {
+        double kt = k[t] > LINE_KMAX ? LINE_KMAX : k[t];
+        while (j < kt) {
+            if (++j) pmf *= alpha > 0.0 ? (j - 1 + r) / j * q : q / j;
+            c += pmf;
+        }
+        cdf[t] = kt < 0.0 ? 0.0 : (c > 1.0 ? 1.0 : c);
+    }
+}
+
+/* P(X > line), P(X < line) and P(X == line) under assist_cdf(). */
+static void line_probs(double mu, double line, double alpha,
+                       double *over, double *under, double *push) {
+    if (isnan(mu) || isnan(line)) {
+        *over = *under = *push = NAN;
+        return;
+    }
+    double k[2] = { ceil(line) - 1.0, floor(line) }, cdf[2];
+    assist_cdf(mu, alpha, k, 2, cdf);
+    *under = cdf[0];
+    *push = cdf[1] - cdf[0];
+    *over = 1.0 - cdf[1];
+}
+
 static Output project(const Inputs *in) {
     Output o;
     o.base_assists = base_assists(in);
@@ -180,81 +301,6237 @@ static Output project(const Inputs *in) {
 
     o.final_multiplier = clamp(o.uncapped_multiplier, MULT_MIN, MULT_MAX);
     o.projection = o.base_assists * o.final_multiplier;
+    line_probs(o.projection, in->line_ast, line_dispersion, &o.p_over, &o.p_under, &o.p_push);
     return o;
 }
 
-/*======================== I/O ========================*/
-static void print_output(const Inputs *in, const Output *o) {
-    printf("\nAssist Projection for %s\n", in->player_name);
-    printf("----------------------------------------\n");
-    printf("Base (blend)            : %.2f\n", o->base_assists);
-    printf("Multipliers:\n");
-    printf("  Home/Away             : %.4f\n", o->m_homeaway);
-    printf("  Game Total (O/U)      : %.4f\n", o->m_game_total);
-    printf("  Team Total (O/U)      : %.4f\n", o->m_team_total);
-    printf("  Opp AST Allowed       : %.4f\n", o->m_def_ast);
-    printf("  Pace                  : %.4f\n", o->m_pace);
-    printf("  Recent Form           : %.4f\n", o->m_recent);
-    printf("  Minutes Trend         : %.4f\n", o->m_minutes);
-    printf("  Back-to-Back          : %.4f\n", o->m_b2b);
-    printf("  Last-5 Potential AST  : %.4f\n", o->m_potential);
-    printf("Uncapped Multiplier     : %.4f\n", o->uncapped_multiplier);
-    printf("Final Multiplier        : %.4f  (capped to [%.2f, %.2f])\n",
-           o->final_multiplier, MULT_MIN, MULT_MAX);
-    printf("Projected Assists       : %.2f\n\n", o->projection);
+/*======================== ARENA & NAME TABLE ========================*/
+/* Bump allocator: everything allocated from an arena is released together
+ * by arena_free(), so a slate's strings cost one free per 64 KiB block
+ * instead of one per player. */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used, cap;
+    max_align_t data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+} Arena;
+
+#define ARENA_BLOCK (64 * 1024)
+
+static void *arena_alloc(Arena *a, size_t n, size_t align) {
+    ArenaBlock *b = a->head;
+    size_t at = b ? (b->used + align - 1) & ~(align - 1) : 0;
+    if (!b || at + n > b->cap) {
+        size_t cap = n + align > ARENA_BLOCK ? n + align : ARENA_BLOCK;
+        b = malloc(sizeof *b + cap);
+        if (!b) return NULL;
+        b->next = a->head;
+        b->used = 0;
+        b->cap = cap;
+        a->head = b;
+        at = 0;
+    }
+    b->used = at + n;
+    return (char *)b->data + at;
 }
 
-int main(void) {
-    Inputs in;
-    static char namebuf[128];
+static char *arena_strndup(Arena *a, const char *s, size_t len) {
+    char *p = arena_alloc(a, len + 1, 1);
+    if (!p) return NULL;
+    memcpy(p, s, len);
+    p[len] = 0;
+    return p;
+}
 
-    printf("Player name: ");
-    if (!fgets(namebuf, sizeof(namebuf), stdin)) return 0;
-    for (int i = 0; namebuf[i]; ++i) { if (namebuf[i] == '\n') { namebuf[i] = 0; break; } }
-    in.player_name = namebuf;
+static void arena_free(Arena *a) {
+    while (a->head) {
+        ArenaBlock *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+}
 
-    printf("Sportsbook line (assists): ");
-    scanf("%lf", &in.line_ast);
+/* Interned player names with dense ids 0..count-1. Strings live in the
+ * table's arena; `slots` is an open-addressed index of id + 1 (0 = empty).
+ * A table built over borrowed strings (an .aslate mapping) has no slots and
+ * only answers strtab_name(). */
+typedef struct {
+    Arena arena;
+    const char **names;          /* id -> name */
+    uint32_t *hashes;            /* id -> hash, for rehashing */
+    uint32_t count, cap;
+    uint32_t *slots;
+    uint32_t nslots;             /* power of two */
+} StrTab;
 
-    printf("Season avg assists: ");
-    scanf("%lf", &in.season_avg_ast);
+#define STRTAB_NONE UINT32_MAX
 
-    printf("Is home? (1=yes, 0=no): ");
-    scanf("%d", &in.is_home);
+static uint32_t str_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;    /* FNV-1a */
+    for (size_t i = 0; i < len; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
 
-    printf("Game total O/U: ");
-    scanf("%lf", &in.game_total_ou);
+static int strtab_grow(StrTab *t) {
+    uint32_t cap = t->cap ? t->cap * 2 : 256;
+    const char **names = realloc(t->names, cap * sizeof *names);
+    if (!names) return -1;
+    t->names = names;
+    uint32_t *hashes = realloc(t->hashes, cap * sizeof *hashes);
+    if (!hashes) return -1;
+    t->hashes = hashes;
+    t->cap = cap;
 
-    printf("Team total O/U: ");
-    scanf("%lf", &in.team_total_ou);
+    uint32_t nslots = cap * 2;
+    uint32_t *slots = calloc(nslots, sizeof *slots);
+    if (!slots) return -1;
+    for (uint32_t id = 0; id < t->count; ++id) {
+        uint32_t i = t->hashes[id] & (nslots - 1);
+        while (slots[i]) i = (i + 1) & (nslots - 1);
+        slots[i] = id + 1;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->nslots = nslots;
+    return 0;
+}
 
-    printf("Opponent assists allowed per game: ");
-    scanf("%lf", &in.opp_ast_allowed);
+/* Returns the id for [s, s+len), adding it if new; STRTAB_NONE on OOM. */
+static uint32_t strtab_intern(StrTab *t, const char *s, size_t len) {
+    uint32_t h = str_hash(s, len);
+    if (t->nslots) {
+        for (uint32_t i = h & (t->nslots - 1); t->slots[i]; i = (i + 1) & (t->nslots - 1)) {
+            uint32_t id = t->slots[i] - 1;
+            const char *name = t->names[id];
+            if (t->hashes[id] == h && memcmp(name, s, len) == 0 && name[len] == 0) return id;
+        }
+    }
+    if (t->count == t->cap && strtab_grow(t) != 0) return STRTAB_NONE;
+    char *copy = arena_strndup(&t->arena, s, len);
+    if (!copy) return STRTAB_NONE;
+    uint32_t id = t->count++;
+    t->names[id] = copy;
+    t->hashes[id] = h;
+    uint32_t i = h & (t->nslots - 1);
+    while (t->slots[i]) i = (i + 1) & (t->nslots - 1);
+    t->slots[i] = id + 1;
+    return id;
+}
 
-    printf("Projected matchup pace (possessions per team): ");
-    scanf("%lf", &in.matchup_pace);
+static const char *strtab_name(const StrTab *t, uint32_t id) {
+    return id < t->count ? t->names[id] : "";
+}
 
-    printf("Recent avg assists (last N; enter season avg to neutralize): ");
-    scanf("%lf", &in.recent_avg_ast);
+/* Id of `name` if interned, else STRTAB_NONE; never adds. */
+static uint32_t strtab_find(const StrTab *t, const char *name) {
+    size_t len = strlen(name);
+    uint32_t h = str_hash(name, len);
+    if (!t->nslots) return STRTAB_NONE;
+    for (uint32_t i = h & (t->nslots - 1); t->slots[i]; i = (i + 1) & (t->nslots - 1)) {
+        uint32_t id = t->slots[i] - 1;
+        if (t->hashes[id] == h && strcmp(t->names[id], name) == 0) return id;
+    }
+    return STRTAB_NONE;
+}
 
-    printf("Season avg minutes: ");
-    scanf("%lf", &in.season_avg_minutes);
+/* Releases every name at once. */
+static void strtab_free(StrTab *t) {
+    arena_free(&t->arena);
+    free(t->names);
+    free(t->hashes);
+    free(t->slots);
+    memset(t, 0, sizeof *t);
+}
 
-    printf("Expected minutes this game: ");
-    scanf("%lf", &in.expected_minutes);
+/*======================== COLUMNAR (SoA) LAYOUT ========================*/
+/* Same fields as Inputs/Output, one contiguous column per field. Every
+ * column starts on a 64-byte boundary and is padded to a whole number of
+ * cache lines, so kernels can stream them without touching the names. */
+typedef struct {
+    size_t n;
+    double *line_ast;
+    double *season_avg_ast;
+    int    *is_home;
+    double *game_total_ou;
+    double *team_total_ou;
+    double *opp_ast_allowed;
+    double *matchup_pace;
+    double *recent_avg_ast;
+    double *season_avg_minutes;
+    double *expected_minutes;
+    int    *is_back_to_back;
+    double *last5_potential_ast;
+    double *last5_conversion;
+    uint32_t *player_id;         /* cold: only touched by the writers */
+    uint32_t *team_id;           /* cold: team-game grouping; NULL = no teams */
+    const StrTab *names;         /* resolves player_id and team_id */
+    void *block;
+} InputsSoA;
 
-    printf("Back-to-back? (1=yes, 0=no): ");
-    scanf("%d", &in.is_back_to_back);
+typedef struct {
+    size_t n;
+    double *base_assists;
+    double *m_homeaway;
+    double *m_game_total;
+    double *m_team_total;
+    double *m_def_ast;
+    double *m_pace;
+    double *m_recent;
+    double *m_minutes;
+    double *m_b2b;
+    double *m_potential;
+    double *uncapped_multiplier;
+    double *final_multiplier;
+    double *projection;
+    double *p_over;
+    double *p_under;
+    double *p_push;
+    void *block;
+} OutputSoA;
 
-    /* === Last-5 potential assists & conversion === */
-    printf("Last-5 average potential assists: ");
-    scanf("%lf", &in.last5_potential_ast);
+#define SOA_ALIGN 64
 
-    printf("Last-5 conversion rate on potential assists (0–1, e.g., 0.54): ");
-    scanf("%lf", &in.last5_conversion);
+static size_t soa_stride(size_t n, size_t elem) {
+    size_t bytes = n * elem;
+    return (bytes + SOA_ALIGN - 1) / SOA_ALIGN * SOA_ALIGN;
+}
 
-    Output out = project(&in);
-    print_output(&in, &out);
+/* Carves `count` columns of `elem`-sized cells out of one aligned block.
+ * cols[i] receives the i-th column; returns the block (NULL on failure). */
+static void *soa_carve(size_t n, const size_t *elem, void **cols[], int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) total += soa_stride(n ? n : 1, elem[i]);
+    char *block = aligned_alloc(SOA_ALIGN, total);
+    if (!block) return NULL;
+    char *p = block;
+    for (int i = 0; i < count; ++i) {
+        *cols[i] = p;
+        p += soa_stride(n ? n : 1, elem[i]);
+    }
+    return block;
+}
+
+static int inputs_soa_alloc(InputsSoA *s, size_t n) {
+    void **cols[] = {
+        (void **)&s->line_ast, (void **)&s->season_avg_ast, (void **)&s->is_home,
+        (void **)&s->game_total_ou, (void **)&s->team_total_ou,
+        (void **)&s->opp_ast_allowed, (void **)&s->matchup_pace,
+        (void **)&s->recent_avg_ast, (void **)&s->season_avg_minutes,
+        (void **)&s->expected_minutes, (void **)&s->is_back_to_back,
+        (void **)&s->last5_potential_ast, (void **)&s->last5_conversion,
+        (void **)&s->player_id, (void **)&s->team_id,
+    };
+    const size_t D = sizeof(double), I = sizeof(int), U = sizeof(uint32_t);
+    const size_t elem[] = { D, D, I, D, D, D, D, D, D, D, I, D, D, U, U };
+    s->block = soa_carve(n, elem, cols, (int)(sizeof(elem) / sizeof(elem[0])));
+    s->n = s->block ? n : 0;
+    return s->block ? 0 : -1;
+}
+
+static int output_soa_alloc(OutputSoA *s, size_t n) {
+    void **cols[] = {
+        (void **)&s->base_assists, (void **)&s->m_homeaway,
+        (void **)&s->m_game_total, (void **)&s->m_team_total,
+        (void **)&s->m_def_ast, (void **)&s->m_pace, (void **)&s->m_recent,
+        (void **)&s->m_minutes, (void **)&s->m_b2b, (void **)&s->m_potential,
+        (void **)&s->uncapped_multiplier, (void **)&s->final_multiplier,
+        (void **)&s->projection, (void **)&s->p_over, (void **)&s->p_under,
+        (void **)&s->p_push,
+    };
+    size_t elem[sizeof(cols) / sizeof(cols[0])];
+    for (size_t i = 0; i < sizeof(elem) / sizeof(elem[0]); ++i) elem[i] = sizeof(double);
+    s->block = soa_carve(n, elem, cols, (int)(sizeof(elem) / sizeof(elem[0])));
+    s->n = s->block ? n : 0;
+    return s->block ? 0 : -1;
+}
+
+static void inputs_soa_free(InputsSoA *s)  { free(s->block); memset(s, 0, sizeof *s); }
+static void output_soa_free(OutputSoA *s)  { free(s->block); memset(s, 0, sizeof *s); }
+
+/* AoS -> SoA. `s` must already hold at least n rows; names resolve
+ * through `names`, which must outlive `s`. */
+static void inputs_to_soa(const Inputs *in, size_t n, const StrTab *names, InputsSoA *s) {
+    s->names = names;
+    for (size_t i = 0; i < n; ++i) {
+        s->player_id[i]           = in[i].player_id;
+        s->team_id[i]             = in[i].team_id;
+        s->line_ast[i]            = in[i].line_ast;
+        s->season_avg_ast[i]      = in[i].season_avg_ast;
+        s->is_home[i]             = in[i].is_home;
+        s->game_total_ou[i]       = in[i].game_total_ou;
+        s->team_total_ou[i]       = in[i].team_total_ou;
+        s->opp_ast_allowed[i]     = in[i].opp_ast_allowed;
+        s->matchup_pace[i]        = in[i].matchup_pace;
+        s->recent_avg_ast[i]      = in[i].recent_avg_ast;
+        s->season_avg_minutes[i]  = in[i].season_avg_minutes;
+        s->expected_minutes[i]    = in[i].expected_minutes;
+        s->is_back_to_back[i]     = in[i].is_back_to_back;
+        s->last5_potential_ast[i] = in[i].last5_potential_ast;
+        s->last5_conversion[i]    = in[i].last5_conversion;
+    }
+}
+
+/*------------------------ column kernels ------------------------*/
+/* Each mirrors its scalar m_* counterpart expression for expression, so the
+ * columnar path is bit-identical to project(). */
+static void base_assists_col(const double *line, const double *season,
+                             double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = W_BASE_LINE * line[i] + W_BASE_SEASON_AVG * season[i];
+}
+
+static void m_homeaway_col(const int *is_home, double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = is_home[i] ? (1.0 + W_HOME_AWAY) : (1.0 - W_HOME_AWAY);
+}
+
+/* Shared shape of the league-baseline factors: 1 + (x - avg) / avg * w. */
+static void m_rel_league_col(const double *x, double avg, double w,
+                             double *out, size_t n) {
+    if (avg <= 0.0) {
+        for (size_t i = 0; i < n; ++i) out[i] = 1.0;
+        return;
+    }
+    for (size_t i = 0; i < n; ++i)
+        out[i] = 1.0 + (x[i] - avg) / avg * w;
+}
+
+/* Shared shape of the per-player factors: 1 + (x - ref) / ref * w, neutral
+ * where the player's own reference is missing. */
+static void m_rel_player_col(const double *x, const double *ref, double w,
+                             double *out, size_t n) {
+    if (w == 0.0) {
+        for (size_t i = 0; i < n; ++i) out[i] = 1.0;
+        return;
+    }
+    for (size_t i = 0; i < n; ++i)
+        out[i] = ref[i] <= 0.0 ? 1.0 : 1.0 + (x[i] - ref[i]) / ref[i] * w;
+}
+
+static void m_b2b_col(const int *is_b2b, double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = (is_b2b[i] && W_BACK_TO_BACK > 0.0) ? (1.0 - W_BACK_TO_BACK) : 1.0;
+}
+
+static void m_potential_assists_col(const double *pot, const double *conv,
+                                    const double *season, double *out, size_t n) {
+    if (W_POTENTIAL_AST == 0.0) {
+        for (size_t i = 0; i < n; ++i) out[i] = 1.0;
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double expected_actual = pot[i] * conv[i];
+        out[i] = season[i] <= 0.0
+               ? 1.0
+               : 1.0 + (expected_actual - season[i]) / season[i] * W_POTENTIAL_AST;
+    }
+}
+
+/* line_probs() over rows [lo, hi), after a kernel has filled projection.
+ * Every batch path runs this same scalar pass, so the probabilities match
+ * project() bit for bit whichever kernel produced the projection. */
+static void line_probs_range(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; ++i)
+        line_probs(o->projection[i], in->line_ast[i], line_dispersion,
+                   &o->p_over[i], &o->p_under[i], &o->p_push[i]);
+}
+
+/* Rows are processed in tiles so the per-factor columns of a tile are still
+ * in L1 when the product pass reads them back. */
+#define SOA_TILE 512
+
+static void project_soa_range(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) {
+    for (size_t t = lo; t < hi; t += SOA_TILE) {
+        size_t n = hi - t < SOA_TILE ? hi - t : SOA_TILE;
+
+        base_assists_col(in->line_ast + t, in->season_avg_ast + t, o->base_assists + t, n);
+        m_homeaway_col(in->is_home + t, o->m_homeaway + t, n);
+        m_rel_league_col(in->game_total_ou + t, LEAGUE_AVG_GAME_TOTAL, W_GAME_TOTAL,
+                         o->m_game_total + t, n);
+        m_rel_league_col(in->team_total_ou + t, LEAGUE_AVG_TEAM_TOTAL, W_TEAM_TOTAL,
+                         o->m_team_total + t, n);
+        m_rel_league_col(in->opp_ast_allowed + t, LEAGUE_AVG_AST_ALLOWED, W_DEF_AST_ALLOWED,
+                         o->m_def_ast + t, n);
+        m_rel_league_col(in->matchup_pace + t, LEAGUE_AVG_PACE, W_PACE,
+                         o->m_pace + t, n);
+        m_rel_player_col(in->recent_avg_ast + t, in->season_avg_ast + t, W_RECENT_FORM,
+                         o->m_recent + t, n);
+        m_rel_player_col(in->expected_minutes + t, in->season_avg_minutes + t, W_MINUTES_TREND,
+                         o->m_minutes + t, n);
+        m_b2b_col(in->is_back_to_back + t, o->m_b2b + t, n);
+        m_potential_assists_col(in->last5_potential_ast + t, in->last5_conversion + t,
+                                in->season_avg_ast + t, o->m_potential + t, n);
+
+        for (size_t i = t; i < t + n; ++i) {
+            o->uncapped_multiplier[i] =
+                o->m_homeaway[i] *
+                o->m_game_total[i] *
+                o->m_team_total[i] *
+                o->m_def_ast[i] *
+                o->m_pace[i] *
+                o->m_recent[i] *
+                o->m_minutes[i] *
+                o->m_b2b[i] *
+                o->m_potential[i];
+            o->final_multiplier[i] = clamp(o->uncapped_multiplier[i], MULT_MIN, MULT_MAX);
+            o->projection[i] = o->base_assists[i] * o->final_multiplier[i];
+        }
+    }
+}
+
+/*======================== SIMD KERNELS & DISPATCH ========================*/
+/* The batch path runs through one of these, picked once at startup from
+ * CPUID. Every kernel evaluates the same expressions in the same order as
+ * the scalar code (no FMA contraction, branches become lane blends), so all
+ * of them agree with project() bit for bit. Tails fall back to scalar. */
+typedef void (*ProjectKernel)(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+
+#define SIMD_KERNEL(isa) __attribute__((target(isa)))
+
+SIMD_KERNEL("sse2")
+static void project_kernel_sse2(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) {
+    const __m128d one = _mm_set1_pd(1.0), zero = _mm_setzero_pd();
+    const __m128d lo_cap = _mm_set1_pd(MULT_MIN), hi_cap = _mm_set1_pd(MULT_MAX);
+    size_t i = lo;
+    for (; i + 2 <= hi; i += 2) {
+#define SEL(m, a, b) _mm_or_pd(_mm_and_pd((m), (a)), _mm_andnot_pd((m), (b)))
+#define REL_LEAGUE(x, avg, w) (avg <= 0.0 ? one : _mm_add_pd(one, _mm_mul_pd(_mm_div_pd( \
+            _mm_sub_pd((x), _mm_set1_pd(avg)), _mm_set1_pd(avg)), _mm_set1_pd(w))))
+        __m128d line = _mm_loadu_pd(in->line_ast + i);
+        __m128d season = _mm_loadu_pd(in->season_avg_ast + i);
+        __m128d base = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(W_BASE_LINE), line),
+                                  _mm_mul_pd(_mm_set1_pd(W_BASE_SEASON_AVG), season));
+
+        __m128d home = _mm_cmpneq_pd(_mm_cvtepi32_pd(
+            _mm_loadl_epi64((const __m128i *)(in->is_home + i))), zero);
+        __m128d ha = SEL(home, _mm_set1_pd(1.0 + W_HOME_AWAY), _mm_set1_pd(1.0 - W_HOME_AWAY));
+        __m128d gt = REL_LEAGUE(_mm_loadu_pd(in->game_total_ou + i), LEAGUE_AVG_GAME_TOTAL, W_GAME_TOTAL);
+        __m128d tt = REL_LEAGUE(_mm_loadu_pd(in->team_total_ou + i), LEAGUE_AVG_TEAM_TOTAL, W_TEAM_TOTAL);
+        __m128d def = REL_LEAGUE(_mm_loadu_pd(in->opp_ast_allowed + i), LEAGUE_AVG_AST_ALLOWED, W_DEF_AST_ALLOWED);
+        __m128d pace = REL_LEAGUE(_mm_loadu_pd(in->matchup_pace + i), LEAGUE_AVG_PACE, W_PACE);
+
+        __m128d no_season = _mm_cmple_pd(season, zero);
+        __m128d recent = one;
+        if (W_RECENT_FORM != 0.0) {
+            __m128d r = _mm_add_pd(one, _mm_mul_pd(_mm_div_pd(_mm_sub_pd(
+                _mm_loadu_pd(in->recent_avg_ast + i), season), season), _mm_set1_pd(W_RECENT_FORM)));
+            recent = SEL(no_season, one, r);
+        }
+        __m128d minutes = one;
+        if (W_MINUTES_TREND != 0.0) {
+            __m128d smin = _mm_loadu_pd(in->season_avg_minutes + i);
+            __m128d r = _mm_add_pd(one, _mm_mul_pd(_mm_div_pd(_mm_sub_pd(
+                _mm_loadu_pd(in->expected_minutes + i), smin), smin), _mm_set1_pd(W_MINUTES_TREND)));
+            minutes = SEL(_mm_cmple_pd(smin, zero), one, r);
+        }
+        __m128d b2b = one;
+        if (W_BACK_TO_BACK > 0.0) {
+            __m128d on = _mm_cmpneq_pd(_mm_cvtepi32_pd(
+                _mm_loadl_epi64((const __m128i *)(in->is_back_to_back + i))), zero);
+            b2b = SEL(on, _mm_set1_pd(1.0 - W_BACK_TO_BACK), one);
+        }
+        __m128d pot = one;
+        if (W_POTENTIAL_AST != 0.0) {
+            __m128d exp_act = _mm_mul_pd(_mm_loadu_pd(in->last5_potential_ast + i),
+                                         _mm_loadu_pd(in->last5_conversion + i));
+            __m128d r = _mm_add_pd(one, _mm_mul_pd(_mm_div_pd(_mm_sub_pd(exp_act, season), season),
+                                                   _mm_set1_pd(W_POTENTIAL_AST)));
+            pot = SEL(no_season, one, r);
+        }
+
+        __m128d m = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(
+            _mm_mul_pd(_mm_mul_pd(ha, gt), tt), def), pace), recent), minutes), b2b), pot);
+        __m128d f = SEL(_mm_cmpgt_pd(m, hi_cap), hi_cap, m);
+        f = SEL(_mm_cmplt_pd(m, lo_cap), lo_cap, f);
+
+        _mm_storeu_pd(o->base_assists + i, base);
+        _mm_storeu_pd(o->m_homeaway + i, ha);
+        _mm_storeu_pd(o->m_game_total + i, gt);
+        _mm_storeu_pd(o->m_team_total + i, tt);
+        _mm_storeu_pd(o->m_def_ast + i, def);
+        _mm_storeu_pd(o->m_pace + i, pace);
+        _mm_storeu_pd(o->m_recent + i, recent);
+        _mm_storeu_pd(o->m_minutes + i, minutes);
+        _mm_storeu_pd(o->m_b2b + i, b2b);
+        _mm_storeu_pd(o->m_potential + i, pot);
+        _mm_storeu_pd(o->uncapped_multiplier + i, m);
+        _mm_storeu_pd(o->final_multiplier + i, f);
+        _mm_storeu_pd(o->projection + i, _mm_mul_pd(base, f));
+#undef REL_LEAGUE
+#undef SEL
+    }
+    project_soa_range(in, o, i, hi);
+}
+
+SIMD_KERNEL("avx2")
+static void project_kernel_avx2(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) {
+    const __m256d one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+    const __m256d lo_cap = _mm256_set1_pd(MULT_MIN), hi_cap = _mm256_set1_pd(MULT_MAX);
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4) {
+#define SEL(m, a, b) _mm256_blendv_pd((b), (a), (m))
+#define REL_LEAGUE(x, avg, w) (avg <= 0.0 ? one : _mm256_add_pd(one, _mm256_mul_pd(_mm256_div_pd( \
+            _mm256_sub_pd((x), _mm256_set1_pd(avg)), _mm256_set1_pd(avg)), _mm256_set1_pd(w))))
+#define NONZERO_I32(p) _mm256_cmp_pd(_mm256_cvtepi32_pd( \
+            _mm_loadu_si128((const __m128i *)(p))), zero, _CMP_NEQ_UQ)
+        __m256d line = _mm256_loadu_pd(in->line_ast + i);
+        __m256d season = _mm256_loadu_pd(in->season_avg_ast + i);
+        __m256d base = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(W_BASE_LINE), line),
+                                     _mm256_mul_pd(_mm256_set1_pd(W_BASE_SEASON_AVG), season));
+
+        __m256d ha = SEL(NONZERO_I32(in->is_home + i),
+                         _mm256_set1_pd(1.0 + W_HOME_AWAY), _mm256_set1_pd(1.0 - W_HOME_AWAY));
+        __m256d gt = REL_LEAGUE(_mm256_loadu_pd(in->game_total_ou + i), LEAGUE_AVG_GAME_TOTAL, W_GAME_TOTAL);
+        __m256d tt = REL_LEAGUE(_mm256_loadu_pd(in->team_total_ou + i), LEAGUE_AVG_TEAM_TOTAL, W_TEAM_TOTAL);
+        __m256d def = REL_LEAGUE(_mm256_loadu_pd(in->opp_ast_allowed + i), LEAGUE_AVG_AST_ALLOWED, W_DEF_AST_ALLOWED);
+        __m256d pace = REL_LEAGUE(_mm256_loadu_pd(in->matchup_pace + i), LEAGUE_AVG_PACE, W_PACE);
+
+        __m256d no_season = _mm256_cmp_pd(season, zero, _CMP_LE_OQ);
+        __m256d recent = one;
+        if (W_RECENT_FORM != 0.0) {
+            __m256d r = _mm256_add_pd(one, _mm256_mul_pd(_mm256_div_pd(_mm256_sub_pd(
+                _mm256_loadu_pd(in->recent_avg_ast + i), season), season), _mm256_set1_pd(W_RECENT_FORM)));
+            recent = SEL(no_season, one, r);
+        }
+        __m256d minutes = one;
+        if (W_MINUTES_TREND != 0.0) {
+            __m256d smin = _mm256_loadu_pd(in->season_avg_minutes + i);
+            __m256d r = _mm256_add_pd(one, _mm256_mul_pd(_mm256_div_pd(_mm256_sub_pd(
+                _mm256_loadu_pd(in->expected_minutes + i), smin), smin), _mm256_set1_pd(W_MINUTES_TREND)));
+            minutes = SEL(_mm256_cmp_pd(smin, zero, _CMP_LE_OQ), one, r);
+        }
+        __m256d b2b = one;
+        if (W_BACK_TO_BACK > 0.0)
+            b2b = SEL(NONZERO_I32(in->is_back_to_back + i), _mm256_set1_pd(1.0 - W_BACK_TO_BACK), one);
+        __m256d pot = one;
+        if (W_POTENTIAL_AST != 0.0) {
+            __m256d exp_act = _mm256_mul_pd(_mm256_loadu_pd(in->last5_potential_ast + i),
+                                            _mm256_loadu_pd(in->last5_conversion + i));
+            __m256d r = _mm256_add_pd(one, _mm256_mul_pd(_mm256_div_pd(_mm256_sub_pd(exp_act, season), season),
+                                                         _mm256_set1_pd(W_POTENTIAL_AST)));
+            pot = SEL(no_season, one, r);
+        }
+
+        __m256d m = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(
+            _mm256_mul_pd(_mm256_mul_pd(ha, gt), tt), def), pace), recent), minutes), b2b), pot);
+        __m256d f = SEL(_mm256_cmp_pd(m, hi_cap, _CMP_GT_OQ), hi_cap, m);
+        f = SEL(_mm256_cmp_pd(m, lo_cap, _CMP_LT_OQ), lo_cap, f);
+
+        _mm256_storeu_pd(o->base_assists + i, base);
+        _mm256_storeu_pd(o->m_homeaway + i, ha);
+        _mm256_storeu_pd(o->m_game_total + i, gt);
+        _mm256_storeu_pd(o->m_team_total + i, tt);
+        _mm256_storeu_pd(o->m_def_ast + i, def);
+        _mm256_storeu_pd(o->m_pace + i, pace);
+        _mm256_storeu_pd(o->m_recent + i, recent);
+        _mm256_storeu_pd(o->m_minutes + i, minutes);
+        _mm256_storeu_pd(o->m_b2b + i, b2b);
+        _mm256_storeu_pd(o->m_potential + i, pot);
+        _mm256_storeu_pd(o->uncapped_multiplier + i, m);
+        _mm256_storeu_pd(o->final_multiplier + i, f);
+        _mm256_storeu_pd(o->projection + i, _mm256_mul_pd(base, f));
+#undef NONZERO_I32
+#undef REL_LEAGUE
+#undef SEL
+    }
+    _mm256_zeroupper();          /* the scalar tail and callers run SSE code */
+    project_soa_range(in, o, i, hi);
+}
+
+SIMD_KERNEL("avx512f")
+static void project_kernel_avx512(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) {
+    const __m512d one = _mm512_set1_pd(1.0), zero = _mm512_setzero_pd();
+    const __m512d lo_cap = _mm512_set1_pd(MULT_MIN), hi_cap = _mm512_set1_pd(MULT_MAX);
+    size_t i = lo;
+    for (; i + 8 <= hi; i += 8) {
+#define SEL(k, a, b) _mm512_mask_blend_pd((k), (b), (a))
+#define REL_LEAGUE(x, avg, w) (avg <= 0.0 ? one : _mm512_add_pd(one, _mm512_mul_pd(_mm512_div_pd( \
+            _mm512_sub_pd((x), _mm512_set1_pd(avg)), _mm512_set1_pd(avg)), _mm512_set1_pd(w))))
+#define NONZERO_I32(p) _mm512_cmp_pd_mask(_mm512_cvtepi32_pd( \
+            _mm256_loadu_si256((const __m256i *)(p))), zero, _CMP_NEQ_UQ)
+        __m512d line = _mm512_loadu_pd(in->line_ast + i);
+        __m512d season = _mm512_loadu_pd(in->season_avg_ast + i);
+        __m512d base = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(W_BASE_LINE), line),
+                                     _mm512_mul_pd(_mm512_set1_pd(W_BASE_SEASON_AVG), season));
+
+        __m512d ha = SEL(NONZERO_I32(in->is_home + i),
+                         _mm512_set1_pd(1.0 + W_HOME_AWAY), _mm512_set1_pd(1.0 - W_HOME_AWAY));
+        __m512d gt = REL_LEAGUE(_mm512_loadu_pd(in->game_total_ou + i), LEAGUE_AVG_GAME_TOTAL, W_GAME_TOTAL);
+        __m512d tt = REL_LEAGUE(_mm512_loadu_pd(in->team_total_ou + i), LEAGUE_AVG_TEAM_TOTAL, W_TEAM_TOTAL);
+        __m512d def = REL_LEAGUE(_mm512_loadu_pd(in->opp_ast_allowed + i), LEAGUE_AVG_AST_ALLOWED, W_DEF_AST_ALLOWED);
+        __m512d pace = REL_LEAGUE(_mm512_loadu_pd(in->matchup_pace + i), LEAGUE_AVG_PACE, W_PACE);
+
+        __mmask8 no_season = _mm512_cmp_pd_mask(season, zero, _CMP_LE_OQ);
+        __m512d recent = one;
+        if (W_RECENT_FORM != 0.0) {
+            __m512d r = _mm512_add_pd(one, _mm512_mul_pd(_mm512_div_pd(_mm512_sub_pd(
+                _mm512_loadu_pd(in->recent_avg_ast + i), season), season), _mm512_set1_pd(W_RECENT_FORM)));
+            recent = SEL(no_season, one, r);
+        }
+        __m512d minutes = one;
+        if (W_MINUTES_TREND != 0.0) {
+            __m512d smin = _mm512_loadu_pd(in->season_avg_minutes + i);
+            __m512d r = _mm512_add_pd(one, _mm512_mul_pd(_mm512_div_pd(_mm512_sub_pd(
+                _mm512_loadu_pd(in->expected_minutes + i), smin), smin), _mm512_set1_pd(W_MINUTES_TREND)));
+            minutes = SEL(_mm512_cmp_pd_mask(smin, zero, _CMP_LE_OQ), one, r);
+        }
+        __m512d b2b = one;
+        if (W_BACK_TO_BACK > 0.0)
+            b2b = SEL(NONZERO_I32(in->is_back_to_back + i), _mm512_set1_pd(1.0 - W_BACK_TO_BACK), one);
+        __m512d pot = one;
+        if (W_POTENTIAL_AST != 0.0) {
+            __m512d exp_act = _mm512_mul_pd(_mm512_loadu_pd(in->last5_potential_ast + i),
+                                            _mm512_loadu_pd(in->last5_conversion + i));
+            __m512d r = _mm512_add_pd(one, _mm512_mul_pd(_mm512_div_pd(_mm512_sub_pd(exp_act, season), season),
+                                                         _mm512_set1_pd(W_POTENTIAL_AST)));
+            pot = SEL(no_season, one, r);
+        }
+
+        __m512d m = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(
+            _mm512_mul_pd(_mm512_mul_pd(ha, gt), tt), def), pace), recent), minutes), b2b), pot);
+        __m512d f = SEL(_mm512_cmp_pd_mask(m, hi_cap, _CMP_GT_OQ), hi_cap, m);
+        f = SEL(_mm512_cmp_pd_mask(m, lo_cap, _CMP_LT_OQ), lo_cap, f);
+
+        _mm512_storeu_pd(o->base_assists + i, base);
+        _mm512_storeu_pd(o->m_homeaway + i, ha);
+        _mm512_storeu_pd(o->m_game_total + i, gt);
+        _mm512_storeu_pd(o->m_team_total + i, tt);
+        _mm512_storeu_pd(o->m_def_ast + i, def);
+        _mm512_storeu_pd(o->m_pace + i, pace);
+        _mm512_storeu_pd(o->m_recent + i, recent);
+        _mm512_storeu_pd(o->m_minutes + i, minutes);
+        _mm512_storeu_pd(o->m_b2b + i, b2b);
+        _mm512_storeu_pd(o->m_potential + i, pot);
+        _mm512_storeu_pd(o->uncapped_multiplier + i, m);
+        _mm512_storeu_pd(o->final_multiplier + i, f);
+        _mm512_storeu_pd(o->projection + i, _mm512_mul_pd(base, f));
+#undef NONZERO_I32
+#undef REL_LEAGUE
+#undef SEL
+    }
+    _mm256_zeroupper();          /* the scalar tail and callers run SSE code */
+    project_soa_range(in, o, i, hi);
+}
+#endif /* x86 */
+
+typedef struct {
+    const char *name;
+    ProjectKernel fn;
+} KernelEntry;
+
+/* Best first; kernel_select() takes the first one the CPU supports. */
+static const KernelEntry KERNELS[] = {
+#ifdef HAVE_X86_KERNELS
+    { "avx512", project_kernel_avx512 },
+    { "avx2",   project_kernel_avx2 },
+    { "sse2",   project_kernel_sse2 },
+#endif
+    { "scalar", project_soa_range },
+};
+#define N_KERNELS (sizeof(KERNELS) / sizeof(KERNELS[0]))
+
+static const KernelEntry *active_kernel;
+
+static int kernel_supported(const KernelEntry *k) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (strcmp(k->name, "avx512") == 0) return __builtin_cpu_supports("avx512f");
+    if (strcmp(k->name, "avx2") == 0)   return __builtin_cpu_supports("avx2");
+    if (strcmp(k->name, "sse2") == 0)   return __builtin_cpu_supports("sse2");
+#endif
+    return strcmp(k->name, "scalar") == 0;
+}
+
+/* Picks the named kernel, or the widest supported one when name is NULL.
+ * Returns -1 if the name is unknown or the CPU cannot run it. */
+static int kernel_select(const char *name) {
+    for (size_t i = 0; i < N_KERNELS; ++i) {
+        const KernelEntry *k = &KERNELS[i];
+        if (name && strcmp(name, k->name) != 0) continue;
+        if (!kernel_supported(k)) {
+            if (name) return -1;
+            continue;
+        }
+        active_kernel = k;
+        return 0;
+    }
+    return -1;
+}
+
+/*======================== PROFILE KERNELS ========================*/
+/* One batch kernel per WEIGHT_PROFILES row. project_folded() is forced
+ * inline into each wrapper with a constant Weights, so the compiler sees
+ * every weight as a literal: factors with a zero weight are dropped, the
+ * league-baseline divisions become multiplies by a folded w/avg, and the
+ * season-average reciprocal is shared by recent form and potential AST.
+ * The reassociation makes these results differ from project() in the last
+ * few ulps; use the dispatch kernels when bit-exactness matters. */
+static inline __attribute__((always_inline))
+void project_folded(const Weights P, const InputsSoA *in, OutputSoA *o,
+                    size_t lo, size_t hi) {
+    const double k_gt   = LEAGUE_AVG_GAME_TOTAL  > 0.0 ? P.game_total / LEAGUE_AVG_GAME_TOTAL : 0.0;
+    const double k_tt   = LEAGUE_AVG_TEAM_TOTAL  > 0.0 ? P.team_total / LEAGUE_AVG_TEAM_TOTAL : 0.0;
+    const double k_def  = LEAGUE_AVG_AST_ALLOWED > 0.0 ? P.def_ast / LEAGUE_AVG_AST_ALLOWED : 0.0;
+    const double k_pace = LEAGUE_AVG_PACE        > 0.0 ? P.pace / LEAGUE_AVG_PACE : 0.0;
+
+    for (size_t i = lo; i < hi; ++i) {
+        double season = in->season_avg_ast[i];
+        double inv_season = (P.recent != 0.0 || P.potential != 0.0) && season > 0.0
+                          ? 1.0 / season : 0.0;
+
+        double base = P.base_line * in->line_ast[i] + P.base_season * season;
+        double ha = in->is_home[i] ? 1.0 + P.home_away : 1.0 - P.home_away;
+        double gt = P.game_total == 0.0 ? 1.0
+                  : 1.0 + (in->game_total_ou[i] - LEAGUE_AVG_GAME_TOTAL) * k_gt;
+        double tt = P.team_total == 0.0 ? 1.0
+                  : 1.0 + (in->team_total_ou[i] - LEAGUE_AVG_TEAM_TOTAL) * k_tt;
+        double def = P.def_ast == 0.0 ? 1.0
+                   : 1.0 + (in->opp_ast_allowed[i] - LEAGUE_AVG_AST_ALLOWED) * k_def;
+        double pace = P.pace == 0.0 ? 1.0
+                    : 1.0 + (in->matchup_pace[i] - LEAGUE_AVG_PACE) * k_pace;
+        double recent = P.recent == 0.0 || season <= 0.0 ? 1.0
+                      : 1.0 + (in->recent_avg_ast[i] - season) * inv_season * P.recent;
+        double minutes = 1.0;
+        if (P.minutes != 0.0 && in->season_avg_minutes[i] > 0.0) {
+            double smin = in->season_avg_minutes[i];
+            minutes = 1.0 + (in->expected_minutes[i] - smin) / smin * P.minutes;
+        }
+        double b2b = in->is_back_to_back[i] && P.b2b > 0.0 ? 1.0 - P.b2b : 1.0;
+        double pot = 1.0;
+        if (P.potential != 0.0 && season > 0.0) {
+            double expected_actual = in->last5_potential_ast[i] * in->last5_conversion[i];
+            pot = 1.0 + (expected_actual - season) * inv_season * P.potential;
+        }
+
+        double m = ha * gt * tt * def * pace * recent * minutes * b2b * pot;
+        double f = clamp(m, P.mult_min, P.mult_max);
+
+        o->base_assists[i] = base;
+        o->m_homeaway[i] = ha;
+        o->m_game_total[i] = gt;
+        o->m_team_total[i] = tt;
+        o->m_def_ast[i] = def;
+        o->m_pace[i] = pace;
+        o->m_recent[i] = recent;
+        o->m_minutes[i] = minutes;
+        o->m_b2b[i] = b2b;
+        o->m_potential[i] = pot;
+        o->uncapped_multiplier[i] = m;
+        o->final_multiplier[i] = f;
+        o->projection[i] = base * f;
+    }
+}
+
+#define DEFINE_PROFILE_KERNEL(name, bl, bs, ha, gt, tt, def, pace, rf, mt, b2b, pot, lo_, hi_) \
+    static void project_profile_##name(const InputsSoA *in, OutputSoA *o, size_t lo, size_t hi) { \
+        project_folded((Weights){ bl, bs, ha, gt, tt, def, pace, rf, mt, b2b, pot, lo_, hi_ },      \
+                       in, o, lo, hi);                                                             \
+    }
+WEIGHT_PROFILES(DEFINE_PROFILE_KERNEL)
+#undef DEFINE_PROFILE_KERNEL
+
+#define PROFILE_ENTRY(name, ...) { #name, project_profile_##name },
+static const KernelEntry PROFILE_KERNELS[] = {
+    WEIGHT_PROFILES(PROFILE_ENTRY)
+};
+#undef PROFILE_ENTRY
+#define N_PROFILES (sizeof(PROFILE_KERNELS) / sizeof(PROFILE_KERNELS[0]))
+
+/* Routes the batch path through a frozen profile kernel instead of the
+ * CPUID-dispatched ones. Returns -1 for an unknown profile. */
+static int profile_select(const char *name) {
+    for (size_t i = 0; i < N_PROFILES; ++i) {
+        if (strcmp(name, PROFILE_KERNELS[i].name) == 0) {
+            active_kernel = &PROFILE_KERNELS[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*======================== THREAD POOL ========================*/
+/* Fixed set of workers that run "task i of n" jobs. Tasks are dealt out as
+ * contiguous ranges, one per worker; a worker that drains its own range
+ * steals the back half of someone else's, so a few slow tasks (explain-mode
+ * rows, ragged chunks) do not leave the rest of the pool idle. The caller
+ * thread takes part as worker 0. Which worker runs a task never affects
+ * where its results land, so output order is deterministic. */
+typedef void (*PoolTaskFn)(void *ctx, size_t task, int worker);
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t lo, hi;               /* remaining tasks [lo, hi) */
+    char pad[64];                /* keep neighbouring deques off this line */
+} PoolDeque;
+
+typedef struct ThreadPool {
+    int nthreads;
+    pthread_t *threads;
+    PoolDeque *deques;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    unsigned long generation;    /* bumped once per pool_run() */
+    int running;                 /* workers still inside the current job */
+    int shutdown;
+
+    PoolTaskFn fn;
+    void *ctx;
+} ThreadPool;
+
+typedef struct {
+    ThreadPool *pool;
+    int id;
+} PoolWorkerArg;
+
+static int pool_take(PoolDeque *d, size_t *task) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->lo < d->hi) { *task = d->lo++; ok = 1; }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/* Moves the back half of a victim's range into our (empty) deque. */
+static int pool_steal(ThreadPool *p, int self) {
+    for (int k = 1; k < p->nthreads; ++k) {
+        PoolDeque *v = &p->deques[(self + k) % p->nthreads];
+        size_t lo = 0, hi = 0;
+        pthread_mutex_lock(&v->lock);
+        if (v->lo < v->hi) {
+            size_t half = (v->hi - v->lo + 1) / 2;
+            hi = v->hi;
+            lo = v->hi = v->hi - half;
+        }
+        pthread_mutex_unlock(&v->lock);
+        if (lo < hi) {
+            PoolDeque *d = &p->deques[self];
+            pthread_mutex_lock(&d->lock);
+            d->lo = lo;
+            d->hi = hi;
+            pthread_mutex_unlock(&d->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void pool_work(ThreadPool *p, int self) {
+    size_t task;
+    for (;;) {
+        while (pool_take(&p->deques[self], &task)) p->fn(p->ctx, task, self);
+        if (!pool_steal(p, self)) break;
+    }
+}
+
+static void *pool_worker_main(void *argp) {
+    PoolWorkerArg *arg = argp;
+    ThreadPool *p = arg->pool;
+    int self = arg->id;
+    unsigned long seen = 0;
+    free(arg);
+
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->generation == seen && !p->shutdown)
+            pthread_cond_wait(&p->start, &p->lock);
+        if (p->shutdown) { pthread_mutex_unlock(&p->lock); return NULL; }
+        seen = p->generation;
+        pthread_mutex_unlock(&p->lock);
+
+        pool_work(p, self);
+
+        pthread_mutex_lock(&p->lock);
+        if (--p->running == 0) pthread_cond_signal(&p->done);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+/* nthreads <= 0 means one per online CPU. */
+static ThreadPool *pool_create(int nthreads) {
+    if (nthreads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    ThreadPool *p = calloc(1, sizeof *p);
+    if (!p) return NULL;
+    p->nthreads = nthreads;
+    p->threads = calloc((size_t)nthreads, sizeof *p->threads);
+    p->deques = calloc((size_t)nthreads, sizeof *p->deques);
+    if (!p->threads || !p->deques) {
+        free(p->threads); free(p->deques); free(p);
+        return NULL;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->start, NULL);
+    pthread_cond_init(&p->done, NULL);
+    for (int i = 0; i < nthreads; ++i) pthread_mutex_init(&p->deques[i].lock, NULL);
+
+    for (int i = 1; i < nthreads; ++i) {
+        PoolWorkerArg *arg = malloc(sizeof *arg);
+        if (arg) { arg->pool = p; arg->id = i; }
+        if (!arg || pthread_create(&p->threads[i], NULL, pool_worker_main, arg) != 0) {
+            free(arg);
+            p->nthreads = i;     /* run with what we managed to start */
+            break;
+        }
+    }
+    return p;
+}
+
+static void pool_destroy(ThreadPool *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->lock);
+    p->shutdown = 1;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+    for (int i = 1; i < p->nthreads; ++i) pthread_join(p->threads[i], NULL);
+    for (int i = 0; i < p->nthreads; ++i) pthread_mutex_destroy(&p->deques[i].lock);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->start);
+    pthread_cond_destroy(&p->done);
+    free(p->threads);
+    free(p->deques);
+    free(p);
+}
+
+/* Runs fn(ctx, t, worker) for every t in [0, ntasks) and returns when all
+ * have finished. Not reentrant: one job at a time per pool. */
+static void pool_run(ThreadPool *p, size_t ntasks, PoolTaskFn fn, void *ctx) {
+    if (ntasks == 0) return;
+    if (p->nthreads == 1 || ntasks == 1) {
+        for (size_t t = 0; t < ntasks; ++t) fn(ctx, t, 0);
+        return;
+    }
+    size_t per = ntasks / (size_t)p->nthreads, extra = ntasks % (size_t)p->nthreads;
+    size_t next = 0;
+    for (int i = 0; i < p->nthreads; ++i) {
+        size_t len = per + ((size_t)i < extra);
+        p->deques[i].lo = next;
+        p->deques[i].hi = next + len;
+        next += len;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->fn = fn;
+    p->ctx = ctx;
+    p->running = p->nthreads - 1;
+    p->generation++;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+
+    pool_work(p, 0);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->running > 0) pthread_cond_wait(&p->done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/*------------------------ parallel batch projection ------------------------*/
+/* Rows per task: big enough to amortize a deque pop, small enough that a
+ * 300-player slate still stays on one core and a backtest splits finely. */
+#define BATCH_CHUNK 4096
+
+typedef struct {
+    const InputsSoA *in;
+    OutputSoA *out;
+    size_t chunk;
+} BatchJob;
+
+static void batch_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    BatchJob *job = ctx;
+    size_t lo = task * job->chunk;
+    size_t hi = lo + job->chunk < job->in->n ? lo + job->chunk : job->in->n;
+    active_kernel->fn(job->in, job->out, lo, hi);
+    line_probs_range(job->in, job->out, lo, hi);
+}
+
+/* Columnar batch entry point: out must hold at least in->n rows. Runs on
+ * the kernel picked by kernel_select(), the widest available by default,
+ * one BATCH_CHUNK of rows per pool task. */
+static void project_batch_parallel(ThreadPool *pool, const InputsSoA *in, OutputSoA *out) {
+    if (!active_kernel) kernel_select(NULL);
+    BatchJob job = { in, out, BATCH_CHUNK };
+    pool_run(pool, (in->n + job.chunk - 1) / job.chunk, batch_task, &job);
+}
+
+/*======================== TEAM-GAME FACTORING ========================*/
+/* Home/away, game total, team total, opponent AST allowed and pace depend
+ * only on the team-game, and they are the first five factors of project()'s
+ * product. So a slate normalizes into
+ *
+ *   GameContext    one row per distinct team-game: its five inputs, five
+ *                  factors and their running product m_team
+ *   PlayerContext  one row per player: game index + the player-level
+ *                  columns (borrowed from the InputsSoA, not copied)
+ *
+ * and each player's multiplier is m_team[game] * recent * minutes * b2b *
+ * potential, evaluated left to right exactly as project() does, so results
+ * are bit-identical. Rows are grouped by their team (the slate's optional
+ * `team` column) together with the bit patterns of the five team inputs.
+ * Without a team, two rows with identical team context share a game, so
+ * two teams with the same lines on one slate would be merged; a group
+ * larger than a roster is the sign of that. */
+#define TEAM_ROSTER_MAX 15
+
+typedef struct {
+    size_t n;
+    uint32_t *team_id;           /* STRTAB_NONE where the slate has no team */
+    int    *is_home;
+    double *game_total_ou;
+    double *team_total_ou;
+    double *opp_ast_allowed;
+    double *matchup_pace;
+    double *m_homeaway;
+    double *m_game_total;
+    double *m_team_total;
+    double *m_def_ast;
+    double *m_pace;
+    double *m_team;              /* product of the five, in project() order */
+    void *block;
+} GameContext;
+
+typedef struct {
+    size_t n;
+    uint32_t *game;              /* row -> GameContext index (owned) */
+    const InputsSoA *cols;       /* player-level columns */
+    void *block;
+} PlayerContext;
+
+static uint64_t f64_bits(double v) {
+    uint64_t u;
+    memcpy(&u, &v, sizeof u);
+    return u;
+}
+
+static uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+static uint32_t row_team(const InputsSoA *in, size_t i) {
+    return in->team_id ? in->team_id[i] : STRTAB_NONE;
+}
+
+static uint64_t team_key_hash(const InputsSoA *in, size_t i) {
+    uint64_t h = mix64((uint64_t)row_team(in, i) << 1 | (uint64_t)(in->is_home[i] != 0));
+    h = mix64(h ^ f64_bits(in->game_total_ou[i]));
+    h = mix64(h ^ f64_bits(in->team_total_ou[i]));
+    h = mix64(h ^ f64_bits(in->opp_ast_allowed[i]));
+    return mix64(h ^ f64_bits(in->matchup_pace[i]));
+}
+
+static int team_key_equal(const InputsSoA *in, size_t i, const GameContext *g, size_t k) {
+    return row_team(in, i) == g->team_id[k] &&
+           (in->is_home[i] != 0) == (g->is_home[k] != 0) &&
+           f64_bits(in->game_total_ou[i])   == f64_bits(g->game_total_ou[k]) &&
+           f64_bits(in->team_total_ou[i])   == f64_bits(g->team_total_ou[k]) &&
+           f64_bits(in->opp_ast_allowed[i]) == f64_bits(g->opp_ast_allowed[k]) &&
+           f64_bits(in->matchup_pace[i])    == f64_bits(g->matchup_pace[k]);
+}
+
+static void game_context_free(GameContext *g)     { free(g->block); memset(g, 0, sizeof *g); }
+static void player_context_free(PlayerContext *p) { free(p->block); memset(p, 0, sizeof *p); }
+
+/* Splits `in` into team-games and players and evaluates the team factors.
+ * Returns 0, or -1 on allocation failure. The GameContext is sized for the
+ * worst case (every row its own team-game); g->n is the distinct count. */
+static int slate_factor(const InputsSoA *in, GameContext *g, PlayerContext *p) {
+    size_t n = in->n;
+    memset(g, 0, sizeof *g);
+    memset(p, 0, sizeof *p);
+
+    void **gcols[] = {
+        (void **)&g->team_id,
+        (void **)&g->is_home, (void **)&g->game_total_ou, (void **)&g->team_total_ou,
+        (void **)&g->opp_ast_allowed, (void **)&g->matchup_pace,
+        (void **)&g->m_homeaway, (void **)&g->m_game_total, (void **)&g->m_team_total,
+        (void **)&g->m_def_ast, (void **)&g->m_pace, (void **)&g->m_team,
+    };
+    const size_t D = sizeof(double);
+    const size_t gelem[] = { sizeof(uint32_t), sizeof(int), D, D, D, D, D, D, D, D, D, D };
+    g->block = soa_carve(n, gelem, gcols, (int)(sizeof(gelem) / sizeof(gelem[0])));
+    void **pcols[] = { (void **)&p->game };
+    const size_t pelem[] = { sizeof(uint32_t) };
+    p->block = soa_carve(n, pelem, pcols, 1);
+
+    size_t nslots = 16;
+    while (nslots < 2 * n) nslots <<= 1;
+    uint32_t *slots = calloc(nslots, sizeof *slots);       /* game index + 1 */
+    if (!g->block || !p->block || !slots) {
+        free(slots);
+        game_context_free(g);
+        player_context_free(p);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t s = team_key_hash(in, i) & (nslots - 1);
+        while (slots[s] && !team_key_equal(in, i, g, slots[s] - 1)) s = (s + 1) & (nslots - 1);
+        if (!slots[s]) {
+            size_t k = g->n++;
+            g->team_id[k]         = row_team(in, i);
+            g->is_home[k]         = in->is_home[i];
+            g->game_total_ou[k]   = in->game_total_ou[i];
+            g->team_total_ou[k]   = in->team_total_ou[i];
+            g->opp_ast_allowed[k] = in->opp_ast_allowed[i];
+            g->matchup_pace[k]    = in->matchup_pace[i];
+            slots[s] = (uint32_t)k + 1;
+        }
+        p->game[i] = slots[s] - 1;
+    }
+    free(slots);
+    p->n = n;
+    p->cols = in;
+
+    m_homeaway_col(g->is_home, g->m_homeaway, g->n);
+    m_rel_league_col(g->game_total_ou, LEAGUE_AVG_GAME_TOTAL, W_GAME_TOTAL, g->m_game_total, g->n);
+    m_rel_league_col(g->team_total_ou, LEAGUE_AVG_TEAM_TOTAL, W_TEAM_TOTAL, g->m_team_total, g->n);
+    m_rel_league_col(g->opp_ast_allowed, LEAGUE_AVG_AST_ALLOWED, W_DEF_AST_ALLOWED, g->m_def_ast, g->n);
+    m_rel_league_col(g->matchup_pace, LEAGUE_AVG_PACE, W_PACE, g->m_pace, g->n);
+    for (size_t k = 0; k < g->n; ++k)
+        g->m_team[k] = g->m_homeaway[k] * g->m_game_total[k] * g->m_team_total[k] *
+                       g->m_def_ast[k] * g->m_pace[k];
+    return 0;
+}
+
+/* Team-games with more rows than a roster holds. */
+static size_t oversized_games(const GameContext *g, const PlayerContext *p) {
+    uint32_t *rows = calloc(g->n ? g->n : 1, sizeof *rows);
+    size_t over = 0;
+    if (!rows) return 0;
+    for (size_t i = 0; i < p->n; ++i)
+        if (++rows[p->game[i]] == TEAM_ROSTER_MAX + 1) ++over;
+    free(rows);
+    return over;
+}
+
+/* Player half of the projection over rows [lo, hi). */
+static void project_factored_range(const GameContext *g, const PlayerContext *p,
+                                   OutputSoA *o, size_t lo, size_t hi) {
+    const InputsSoA *in = p->cols;
+    for (size_t t = lo; t < hi; t += SOA_TILE) {
+        size_t n = hi - t < SOA_TILE ? hi - t : SOA_TILE;
+
+        base_assists_col(in->line_ast + t, in->season_avg_ast + t, o->base_assists + t, n);
+        m_rel_player_col(in->recent_avg_ast + t, in->season_avg_ast + t, W_RECENT_FORM,
+                         o->m_recent + t, n);
+        m_rel_player_col(in->expected_minutes + t, in->season_avg_minutes + t, W_MINUTES_TREND,
+                         o->m_minutes + t, n);
+        m_b2b_col(in->is_back_to_back + t, o->m_b2b + t, n);
+        m_potential_assists_col(in->last5_potential_ast + t, in->last5_conversion + t,
+                                in->season_avg_ast + t, o->m_potential + t, n);
+
+        for (size_t i = t; i < t + n; ++i) {
+            uint32_t k = p->game[i];
+            o->m_homeaway[i]   = g->m_homeaway[k];
+            o->m_game_total[i] = g->m_game_total[k];
+            o->m_team_total[i] = g->m_team_total[k];
+            o->m_def_ast[i]    = g->m_def_ast[k];
+            o->m_pace[i]       = g->m_pace[k];
+            o->uncapped_multiplier[i] =
+                g->m_team[k] * o->m_recent[i] * o->m_minutes[i] * o->m_b2b[i] * o->m_potential[i];
+            o->final_multiplier[i] = clamp(o->uncapped_multiplier[i], MULT_MIN, MULT_MAX);
+            o->projection[i] = o->base_assists[i] * o->final_multiplier[i];
+        }
+    }
+    line_probs_range(in, o, lo, hi);
+}
+
+typedef struct {
+    const GameContext *g;
+    const PlayerContext *p;
+    OutputSoA *out;
+} FactoredJob;
+
+static void factored_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    FactoredJob *job = ctx;
+    size_t lo = task * BATCH_CHUNK;
+    size_t hi = lo + BATCH_CHUNK < job->p->n ? lo + BATCH_CHUNK : job->p->n;
+    project_factored_range(job->g, job->p, job->out, lo, hi);
+}
+
+/* Same results as project_batch_parallel(), team factors computed once per
+ * team-game. */
+static void project_batch_factored(ThreadPool *pool, const GameContext *g,
+                                   const PlayerContext *p, OutputSoA *out) {
+    FactoredJob job = { g, p, out };
+    pool_run(pool, (p->n + BATCH_CHUNK - 1) / BATCH_CHUNK, factored_task, &job);
+}
+
+/*======================== TEAM NORMALIZATION ========================*/
+/* A team's projections can add up to more assists than its team total
+ * supports. The budget for a team-game is
+ *   B = team_total_ou / PTS_PER_FGM * TEAM_AST_RATE
+ * and it is an upper bound: a slate rarely lists the whole roster, so a
+ * team that comes in under budget keeps its projections. Each player's
+ * projection is first capped at NORM_CAP_LINE * line. If the team is still
+ * over budget, every player is scaled by a common s < 1, but nobody goes
+ * below their floor min(capped, NORM_FLOOR_LINE * line):
+ *   sum_i max(s * y_i, floor_i) = B.
+ * s is found by repeatedly pinning the players who fall to their floor and
+ * rescaling the rest. s only shrinks, so the pinned set only grows. Each
+ * round is one pass over the rows with per-game sums, and the number of
+ * rounds is bounded by the largest team (usually two). If the floors
+ * alone exceed B, everyone sits at their floor. Only projection and the
+ * line probabilities change; the factor columns stay as project()
+ * computed them. Rows without a line get no floor or cap. Returns 0, or
+ * -1 on allocation failure. */
+static double norm_cap(const InputsSoA *in, const OutputSoA *o, size_t i) {
+    double proj = o->projection[i], line = in->line_ast[i];
+    return line > 0.0 && proj > NORM_CAP_LINE * line ? NORM_CAP_LINE * line : proj;
+}
+
+static double norm_floor(const InputsSoA *in, double y, size_t i) {
+    double lo = in->line_ast[i] > 0.0 ? NORM_FLOOR_LINE * in->line_ast[i] : 0.0;
+    return lo < y ? lo : y;
+}
+
+static int team_normalize(const GameContext *g, const PlayerContext *p, OutputSoA *o) {
+    const InputsSoA *in = p->cols;
+    size_t ng = g->n;
+    double *budget = malloc(4 * (ng ? ng : 1) * sizeof *budget);
+    if (!budget) return -1;
+    double *scale = budget + ng, *pinned = scale + ng, *free_y = pinned + ng;
 
+    for (size_t k = 0; k < ng; ++k) {
+        double tt = g->team_total_ou[k] > 0.0 ? g->team_total_ou[k] : LEAGUE_AVG_TEAM_TOTAL;
+        budget[k] = tt / PTS_PER_FGM * TEAM_AST_RATE;
+        free_y[k] = 0.0;
+    }
+    for (size_t i = 0; i < p->n; ++i) free_y[p->game[i]] += norm_cap(in, o, i);
+    for (size_t k = 0; k < ng; ++k) scale[k] = free_y[k] > budget[k] ? budget[k] / free_y[k] : 1.0;
+
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        memset(pinned, 0, 2 * ng * sizeof *pinned);
+        for (size_t i = 0; i < p->n; ++i) {
+            uint32_t k = p->game[i];
+            if (scale[k] >= 1.0) continue;
+            double y = norm_cap(in, o, i), lo = norm_floor(in, y, i);
+            if (scale[k] * y <= lo) pinned[k] += lo;
+            else free_y[k] += y;
+        }
+        for (size_t k = 0; k < ng; ++k) {
+            if (scale[k] >= 1.0) continue;
+            double s = free_y[k] > 0.0 && budget[k] > pinned[k] ? (budget[k] - pinned[k]) / free_y[k] : 0.0;
+            if (s != scale[k]) { scale[k] = s; changed = 1; }
+        }
+    }
+
+    for (size_t i = 0; i < p->n; ++i) {
+        double y = norm_cap(in, o, i), s = scale[p->game[i]];
+        if (s < 1.0) {
+            double lo = norm_floor(in, y, i);
+            y = s * y > lo ? s * y : lo;
+        }
+        if (y != o->projection[i]) {
+            o->projection[i] = y;
+            line_probs_range(in, o, i, i + 1);
+        }
+    }
+    free(budget);
     return 0;
 }
+
+/*======================== LADDER PRICING ========================*/
+/* Fair prices for a ladder of alternate lines (say 2.5 through 12.5). The
+ * lines must be strictly ascending, so their CDF points are too, and
+ * assist_cdf() prices the whole ladder in the one pass that a single line
+ * would take. Fair American odds carry no vig: the win payout at which the
+ * bet breaks even, with pushes refunded. */
+#define LADDER_MAX 64
+
+typedef struct {
+    double lines[LADDER_MAX];
+    int n;
+} Ladder;
+
+typedef struct {
+    double p_over, p_under, p_push;
+    double fair_over, fair_under;    /* American odds */
+} LinePrice;
+
+/* "LO:HI[:STEP]" (step 1) or a comma list "4.5,6.5,8.5"; ascending only. */
+static int parse_ladder(const char *s, Ladder *l) {
+    char *end;
+    l->n = 0;
+    double lo = strtod(s, &end);
+    if (end == s) return -1;
+    if (*end == ':') {
+        double hi = strtod(end + 1, &end), step = 1.0;
+        if (*end == ':') step = strtod(end + 1, &end);
+        if (*end || !(step > 0.0) || !(hi >= lo)) return -1;
+        for (double x = lo; x <= hi + step * 1e-9; x = lo + step * l->n) {
+            if (l->n == LADDER_MAX) return -1;
+            l->lines[l->n++] = x;
+        }
+        return 0;
+    }
+    l->lines[l->n++] = lo;
+    while (*end == ',') {
+        if (l->n == LADDER_MAX) return -1;
+        const char *next = end + 1;
+        double x = strtod(next, &end);
+        if (end == next || !(x > l->lines[l->n - 1])) return -1;
+        l->lines[l->n++] = x;
+    }
+    return *end ? -1 : 0;
+}
+
+/* Fair American odds for a bet that wins with p_win and loses with p_lose;
+ * +inf when it cannot win, -inf when it cannot lose. */
+static double fair_american(double p_win, double p_lose) {
+    if (!(p_win > 0.0)) return p_win == 0.0 ? INFINITY : NAN;
+    double b = p_lose / p_win;           /* break-even profit per unit staked */
+    if (b == 0.0) return -INFINITY;
+    return b >= 1.0 ? 100.0 * b : -100.0 / b;
+}
+
+/* Prices every line of the ladder for one projection. */
+static void price_ladder(double mu, double alpha, const Ladder *l, LinePrice *out) {
+    double k[2 * LADDER_MAX], cdf[2 * LADDER_MAX];
+    if (l->n <= 0) return;
+    if (isnan(mu)) {
+        for (int t = 0; t < l->n; ++t)
+            out[t] = (LinePrice){ NAN, NAN, NAN, NAN, NAN };
+        return;
+    }
+    for (int t = 0; t < l->n; ++t) {
+        k[2 * t] = ceil(l->lines[t]) - 1.0;
+        k[2 * t + 1] = floor(l->lines[t]);
+    }
+    assist_cdf(mu, alpha, k, 2 * l->n, cdf);
+    for (int t = 0; t < l->n; ++t) {
+        LinePrice *p = &out[t];
+        p->p_under = cdf[2 * t];
+        p->p_push = cdf[2 * t + 1] - cdf[2 * t];
+        p->p_over = 1.0 - cdf[2 * t + 1];
+        p->fair_over = fair_american(p->p_over, p->p_under);
+        p->fair_under = fair_american(p->p_under, p->p_over);
+    }
+}
+
+typedef struct {
+    const double *projection;
+    size_t n;
+    const Ladder *ladder;
+    LinePrice *out;
+} LadderJob;
+
+static void ladder_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    LadderJob *job = ctx;
+    size_t lo = task * BATCH_CHUNK;
+    size_t hi = lo + BATCH_CHUNK < job->n ? lo + BATCH_CHUNK : job->n;
+    for (size_t i = lo; i < hi; ++i)
+        price_ladder(job->projection[i], line_dispersion, job->ladder,
+                     job->out + i * (size_t)job->ladder->n);
+}
+
+/* The ladder for every row of a projected slate; out is n * ladder->n
+ * prices, row-major (all lines of row 0, then row 1, ...). */
+static void price_ladder_batch(ThreadPool *pool, const OutputSoA *res, const Ladder *ladder,
+                               LinePrice *out) {
+    LadderJob job = { res->projection, res->n, ladder, out };
+    pool_run(pool, (res->n + BATCH_CHUNK - 1) / BATCH_CHUNK, ladder_task, &job);
+}
+
+/*======================== MONTE CARLO ========================*/
+/* Draws simulated assist outcomes for every player: nsims draws from the
+ * same negative binomial that line_probs() uses, with its mean at the
+ * projection. Each player's CDF is tabulated once, and each draw is an
+ * inverse-CDF lookup of one uniform (a branch-free binary search).
+ *
+ * Uniforms come from Philox4x32-10, a counter-based generator: draw s of
+ * player i is word s%4 of philox(counter {s/4, i, stream, 0}, key seed).
+ * Every draw is a pure function of (seed, player, sim). Results do not
+ * depend on thread count or chunking, and any draw can be regenerated on
+ * its own. Blocks of SIM_LANES counters run through the rounds together;
+ * with AVX2 that is one 8-lane vector per Philox word. */
+#define SIM_TABLE 256            /* outcomes 0..255; the last entry catches the tail */
+#define SIM_LANES 8
+#define SIM_BLOCK (SIM_LANES * 4)
+#define SIM_PLAYER_CHUNK 16
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+/* Ten Philox rounds over SIM_LANES counters, in place. c[w][lane] is word w. */
+typedef void (*PhiloxKernel)(uint32_t c[4][SIM_LANES], uint32_t k0, uint32_t k1);
+
+static void philox_lanes(uint32_t c[4][SIM_LANES], uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < 10; ++r) {
+        for (int l = 0; l < SIM_LANES; ++l) {
+            uint64_t p0 = (uint64_t)PHILOX_M0 * c[0][l], p1 = (uint64_t)PHILOX_M1 * c[2][l];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c[1][l] ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c[3][l] ^ k1;
+            c[1][l] = (uint32_t)p1;
+            c[3][l] = (uint32_t)p0;
+            c[0][l] = n0;
+            c[2][l] = n2;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+SIMD_KERNEL("avx2")
+static void philox_lanes_avx2(uint32_t c[4][SIM_LANES], uint32_t k0, uint32_t k1) {
+    __m256i x0 = _mm256_loadu_si256((const __m256i *)c[0]);
+    __m256i x1 = _mm256_loadu_si256((const __m256i *)c[1]);
+    __m256i x2 = _mm256_loadu_si256((const __m256i *)c[2]);
+    __m256i x3 = _mm256_loadu_si256((const __m256i *)c[3]);
+    const __m256i m0 = _mm256_set1_epi32((int)PHILOX_M0), m1 = _mm256_set1_epi32((int)PHILOX_M1);
+    __m256i kv0 = _mm256_set1_epi32((int)k0), kv1 = _mm256_set1_epi32((int)k1);
+    const __m256i w0 = _mm256_set1_epi32((int)PHILOX_W0), w1 = _mm256_set1_epi32((int)PHILOX_W1);
+    for (int r = 0; r < 10; ++r) {
+        /* 32x32->64 products of even and odd lanes, re-interleaved into hi/lo words */
+        __m256i e0 = _mm256_mul_epu32(x0, m0), o0 = _mm256_mul_epu32(_mm256_srli_epi64(x0, 32), m0);
+        __m256i e1 = _mm256_mul_epu32(x2, m1), o1 = _mm256_mul_epu32(_mm256_srli_epi64(x2, 32), m1);
+        __m256i lo0 = _mm256_blend_epi32(e0, _mm256_slli_epi64(o0, 32), 0xAA);
+        __m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(e0, 32), o0, 0xAA);
+        __m256i lo1 = _mm256_blend_epi32(e1, _mm256_slli_epi64(o1, 32), 0xAA);
+        __m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(e1, 32), o1, 0xAA);
+        x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), kv0);
+        x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), kv1);
+        x1 = lo1;
+        x3 = lo0;
+        kv0 = _mm256_add_epi32(kv0, w0);
+        kv1 = _mm256_add_epi32(kv1, w1);
+    }
+    _mm256_storeu_si256((__m256i *)c[0], x0);
+    _mm256_storeu_si256((__m256i *)c[1], x1);
+    _mm256_storeu_si256((__m256i *)c[2], x2);
+    _mm256_storeu_si256((__m256i *)c[3], x3);
+    _mm256_zeroupper();
+}
+#endif
+
+/* AVX2 unless the active batch kernel is narrower (or --kernel forced one). */
+static PhiloxKernel philox_kernel(void) {
+#ifdef HAVE_X86_KERNELS
+    if (!active_kernel) kernel_select(NULL);
+    if (strcmp(active_kernel->name, "avx512") == 0 || strcmp(active_kernel->name, "avx2") == 0)
+        return philox_lanes_avx2;
+#endif
+    return philox_lanes;
+}
+
+typedef struct {
+    size_t nsims;
+    uint64_t seed;
+    uint32_t stream;             /* separates independent uses of one seed */
+    int teams;                   /* correlated teammates (simulate_slate_teams) */
+} SimOptions;
+
+/* Outcome distribution of one player's draws. */
+typedef struct {
+    double mean, sd;
+    double p_over, p_under, p_push;  /* against line_ast */
+    double q10, q50, q90;
+} SimSummary;
+
+/* Inverse-CDF table: cdf[k] = P(X <= k), with the last entry forced above
+ * every uniform so the search always lands. */
+static void sim_table(double mu, double alpha, double *cdf) {
+    double k[SIM_TABLE - 1];
+    for (int j = 0; j < SIM_TABLE - 1; ++j) k[j] = j;
+    assist_cdf(isnan(mu) ? 0.0 : mu, alpha, k, SIM_TABLE - 1, cdf);
+    cdf[SIM_TABLE - 1] = 2.0;
+}
+
+/* The same table for Binomial(n, p), integral n < SIM_TABLE - 1. */
+static void binomial_table(double n, double p, double *cdf) {
+    if (p >= 1.0) {
+        for (int j = 0; j < SIM_TABLE - 1; ++j) cdf[j] = j >= n ? 1.0 : 0.0;
+        cdf[SIM_TABLE - 1] = 2.0;
+        return;
+    }
+    double pmf = exp(n * log1p(-p)), odds = p / (1.0 - p), c = 0.0;
+    for (int j = 0; j < SIM_TABLE - 1; ++j) {
+        if (j) pmf = j > n ? 0.0 : pmf * (n - j + 1) / j * odds;
+        c += pmf;
+        cdf[j] = c > 1.0 ? 1.0 : c;
+    }
+    cdf[SIM_TABLE - 1] = 2.0;
+}
+
+/* Smallest k with u < cdf[k]: the count of table entries <= u. */
+static int sim_lookup(const double *cdf, double u) {
+    int k = 0;
+    for (int step = SIM_TABLE / 2; step > 0; step /= 2)
+        k += (cdf[k + step - 1] <= u) ? step : 0;
+    return k;
+}
+
+/* Draws sims [0, nsims) of player `player` into draws (if not NULL) and
+ * the outcome histogram hist[SIM_TABLE]. */
+static void simulate_player(PhiloxKernel philox, const SimOptions *opt, uint32_t player,
+                            const double *cdf, uint8_t *draws, uint64_t *hist) {
+    uint32_t k0 = (uint32_t)opt->seed, k1 = (uint32_t)(opt->seed >> 32);
+    for (size_t s0 = 0; s0 < opt->nsims; s0 += SIM_BLOCK) {
+        uint32_t c[4][SIM_LANES];
+        for (int l = 0; l < SIM_LANES; ++l) {
+            c[0][l] = (uint32_t)(s0 / 4) + (uint32_t)l;
+            c[1][l] = player;
+            c[2][l] = opt->stream;
+            c[3][l] = 0;
+        }
+        philox(c, k0, k1);
+        size_t left = opt->nsims - s0;
+        for (int l = 0; l < SIM_LANES; ++l) {
+            for (int w = 0; w < 4; ++w) {
+                size_t s = (size_t)l * 4 + (size_t)w;
+                if (s >= left) break;
+                int x = sim_lookup(cdf, ((double)c[w][l] + 0.5) * 0x1p-32);
+                hist[x]++;
+                if (draws) draws[s0 + s] = (uint8_t)x;
+            }
+        }
+    }
+}
+
+static void sim_summarize(const uint64_t *hist, size_t nsims, double line, SimSummary *out) {
+    double n = (double)nsims, sum = 0.0, sq = 0.0;
+    double over = 0.0, under = 0.0, push = 0.0;
+    double q[3] = { 0.10, 0.50, 0.90 }, qv[3] = { NAN, NAN, NAN };
+    uint64_t cum = 0;
+    for (int k = 0; k < SIM_TABLE; ++k) {
+        if (!hist[k]) continue;
+        double h = (double)hist[k];
+        sum += h * k;
+        sq += h * k * k;
+        if (k > line) over += h;
+        else if (k < line) under += h;
+        else push += h;
+        cum += hist[k];
+        for (int t = 0; t < 3; ++t)
+            if (isnan(qv[t]) && (double)cum >= q[t] * n) qv[t] = k;
+    }
+    double mean = sum / n;
+    *out = (SimSummary){
+        mean, sqrt(sq / n - mean * mean > 0.0 ? sq / n - mean * mean : 0.0),
+        over / n, under / n, push / n, qv[0], qv[1], qv[2],
+    };
+}
+
+typedef struct {
+    const InputsSoA *in;
+    const OutputSoA *res;
+    const SimOptions *opt;
+    PhiloxKernel philox;
+    uint8_t *draws;
+    SimSummary *summary;
+} SimJob;
+
+static void sim_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    SimJob *job = ctx;
+    size_t lo = task * SIM_PLAYER_CHUNK;
+    size_t hi = lo + SIM_PLAYER_CHUNK < job->res->n ? lo + SIM_PLAYER_CHUNK : job->res->n;
+    double cdf[SIM_TABLE];
+    uint64_t hist[SIM_TABLE];
+    for (size_t i = lo; i < hi; ++i) {
+        memset(hist, 0, sizeof hist);
+        sim_table(job->res->projection[i], line_dispersion, cdf);
+        simulate_player(job->philox, job->opt, (uint32_t)i, cdf,
+                        job->draws ? job->draws + i * job->opt->nsims : NULL, hist);
+        sim_summarize(hist, job->opt->nsims, job->in->line_ast[i], &job->summary[i]);
+    }
+}
+
+/* Simulates every projected row. draws, if not NULL, receives n * nsims
+ * outcomes, player-major; summary receives n entries. */
+static void simulate_slate(ThreadPool *pool, const InputsSoA *in, const OutputSoA *res,
+                           const SimOptions *opt, uint8_t *draws, SimSummary *summary) {
+    SimJob job = { in, res, opt, philox_kernel(), draws, summary };
+    pool_run(pool, (res->n + SIM_PLAYER_CHUNK - 1) / SIM_PLAYER_CHUNK, sim_task, &job);
+}
+
+/*------------------------ correlated teammates ------------------------*/
+/* Teammates compete for the same made baskets, so their assists move
+ * against each other. The simulation works per team-game, which is the
+ * GameContext grouping: exactly the rows that share a team context. Each
+ * sim draws the team's made field goals M ~ Binomial(N, pct). The mean of M
+ * is team_total_ou / PTS_PER_FGM, raised if needed so that the members'
+ * projections use at most MAX_AST_RATE of it. Each make is then credited
+ * as an assist to one member, or to nobody, through a Polya urn: the
+ * chance a make goes to member j is
+ *   (beta_j + assists j has so far) / (kappa + makes handed out so far),
+ * with beta_j = kappa * mu_j / E[M]. Every member's mean is exactly its
+ * projection. kappa is chosen so the Dirichlet share variance equals
+ * dispersion * p^2 at the team's projection-weighted share p. That gives
+ * each player roughly the spread of the independent simulation, while the
+ * underdispersed pool keeps teammates negatively correlated. With
+ * dispersion 0 the urn becomes a plain multinomial.
+ *
+ * Team g, sim s draws from philox counters {s, g, stream + 1, j},
+ * j = 0, 1, ...: one uniform for M, then one per make. Sim s is joint across
+ * the slate, so a combo is priced by counting the sims where it hits. */
+/* Uniforms for one (team, sim), refilled SIM_BLOCK at a time. */
+typedef struct {
+    PhiloxKernel philox;
+    uint32_t k0, k1;
+    uint32_t sim, team, stream, next;
+    uint32_t c[4][SIM_LANES];
+    int used;
+} SimStream;
+
+static void sim_stream_start(SimStream *st, uint32_t sim) {
+    st->sim = sim;
+    st->next = 0;
+    st->used = SIM_BLOCK;
+}
+
+static double sim_stream_uniform(SimStream *st) {
+    if (st->used == SIM_BLOCK) {
+        for (int l = 0; l < SIM_LANES; ++l) {
+            st->c[0][l] = st->sim;
+            st->c[1][l] = st->team;
+            st->c[2][l] = st->stream;
+            st->c[3][l] = st->next + (uint32_t)l;
+        }
+        st->next += SIM_LANES;
+        st->philox(st->c, st->k0, st->k1);
+        st->used = 0;
+    }
+    int u = st->used++;
+    return ((double)st->c[u % 4][u / 4] + 0.5) * 0x1p-32;
+}
+
+typedef struct {
+    const OutputSoA *res;
+    const InputsSoA *in;
+    const uint32_t *offsets;     /* team g's members: members[offsets[g] .. offsets[g+1]) */
+    const uint32_t *members;
+    const SimOptions *opt;
+    PhiloxKernel philox;
+    uint8_t *draws;
+    SimSummary *summary;
+    int failed;                  /* set atomically by any worker; read after pool_run() */
+} TeamSimJob;
+
+static void team_sim_task(void *ctx, size_t team, int worker) {
+    (void)worker;
+    TeamSimJob *job = ctx;
+    const uint32_t *mem = job->members + job->offsets[team];
+    size_t k = job->offsets[team + 1] - job->offsets[team];
+    size_t nsims = job->opt->nsims;
+
+    uint64_t *hist = calloc(k * SIM_TABLE, sizeof *hist);
+    double *share = malloc(k * sizeof *share);
+    uint32_t *cnt = malloc(k * sizeof *cnt);
+    if (!hist || !share || !cnt) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        free(hist); free(share); free(cnt);
+        return;
+    }
+    double total = 0.0;
+    for (size_t j = 0; j < k; ++j) {
+        double mu = job->res->projection[mem[j]];
+        share[j] = mu > 0.0 ? mu : 0.0;
+        total += share[j];
+    }
+    double team_total = job->in->team_total_ou[mem[0]];
+    double makes = (team_total > 0.0 ? team_total : LEAGUE_AVG_TEAM_TOTAL) / PTS_PER_FGM;
+    if (makes < total / MAX_AST_RATE) makes = total / MAX_AST_RATE;
+    double attempts = ceil(makes / TEAM_FG_PCT);
+    if (attempts > SIM_TABLE - 2) attempts = SIM_TABLE - 2;
+    if (makes > attempts) makes = attempts;
+    double fgm_cdf[SIM_TABLE];
+    binomial_table(attempts, attempts > 0.0 ? makes / attempts : 0.0, fgm_cdf);
+
+    /* Dirichlet shares have variance p(1-p)/(1+kappa); the negative binomial
+     * asks for dispersion*p^2. Match them at the projection-weighted share. */
+    double sq = 0.0;
+    for (size_t j = 0; j < k; ++j) sq += share[j] * share[j];
+    double pbar = total > 0.0 ? sq / total / makes : 0.0, kappa = 0.0;
+    if (line_dispersion > 0.0 && pbar > 0.0) {
+        kappa = (1.0 - pbar) / (line_dispersion * pbar) - 1.0;
+        if (kappa < 1.0) kappa = 1.0;
+    }
+    /* beta_j, in units where the urn starts at kappa (1 without an urn) */
+    for (size_t j = 0; j < k; ++j) share[j] = makes > 0.0 ? share[j] / makes * (kappa > 0.0 ? kappa : 1.0) : 0.0;
+
+    SimStream st = { job->philox, (uint32_t)job->opt->seed, (uint32_t)(job->opt->seed >> 32),
+                     0, (uint32_t)team, job->opt->stream + 1, 0, {{0}}, 0 };
+    for (size_t s = 0; s < nsims; ++s) {
+        sim_stream_start(&st, (uint32_t)s);
+        memset(cnt, 0, k * sizeof *cnt);
+        int m = sim_lookup(fgm_cdf, sim_stream_uniform(&st));
+        for (int a = 0; a < m; ++a) {
+            double target = sim_stream_uniform(&st) * (kappa > 0.0 ? kappa + a : 1.0);
+            double acc = 0.0;
+            for (size_t j = 0; j < k; ++j) {
+                acc += kappa > 0.0 ? share[j] + cnt[j] : share[j];
+                if (target < acc) { cnt[j]++; break; }
+            }
+        }
+        for (size_t j = 0; j < k; ++j) {
+            uint8_t x = (uint8_t)(cnt[j] < SIM_TABLE - 1 ? cnt[j] : SIM_TABLE - 1);
+            hist[j * SIM_TABLE + x]++;
+            if (job->draws) job->draws[(size_t)mem[j] * nsims + s] = x;
+        }
+    }
+    for (size_t j = 0; j < k; ++j)
+        sim_summarize(hist + j * SIM_TABLE, nsims, job->in->line_ast[mem[j]], &job->summary[mem[j]]);
+    free(hist);
+    free(share);
+    free(cnt);
+}
+
+/* Correlated version of simulate_slate(): rows are grouped into teams by
+ * p (from slate_factor()). Returns -1 on allocation failure. */
+static int simulate_slate_teams(ThreadPool *pool, const InputsSoA *in, const OutputSoA *res,
+                                const PlayerContext *p, size_t nteams, const SimOptions *opt,
+                                uint8_t *draws, SimSummary *summary) {
+    uint32_t *offsets = calloc(nteams + 1, sizeof *offsets);
+    uint32_t *members = malloc((p->n ? p->n : 1) * sizeof *members);
+    if (!offsets || !members) {
+        free(offsets); free(members);
+        return -1;
+    }
+    for (size_t i = 0; i < p->n; ++i) offsets[p->game[i] + 1]++;
+    for (size_t g = 0; g < nteams; ++g) offsets[g + 1] += offsets[g];
+    for (size_t i = 0; i < p->n; ++i) members[offsets[p->game[i]]++] = (uint32_t)i;
+    for (size_t g = nteams; g > 0; --g) offsets[g] = offsets[g - 1];
+    offsets[0] = 0;
+
+    TeamSimJob job = { res, in, offsets, members, opt, philox_kernel(), draws, summary, 0 };
+    pool_run(pool, nteams, team_sim_task, &job);
+    free(offsets);
+    free(members);
+    return job.failed ? -1 : 0;
+}
+
+/*======================== WEIGHT GRADIENTS ========================*/
+/* The projection as a function of a Weights vector: the 11 weights and the
+ * 2 caps, viewed as 13 doubles in declaration order. project_grad_row()
+ * returns the projection together with d(projection)/d(param) for every
+ * parameter. At default_weights() the projection matches project() bit for
+ * bit.
+ *
+ * With base = w_line*line + w_season*season, m the product of the nine
+ * factors and c = clamp(m, mult_min, mult_max):
+ *   dp/dw_line = line*c,  dp/dw_season = season*c
+ *   dp/dw_k    = base * (product of the other factors) * df_k/dw_k
+ *                when m is inside the caps, 0 when it is capped
+ *   dp/dmult_min = base when m < mult_min, dp/dmult_max = base when m > mult_max
+ * The product of the other factors comes from prefix and suffix products,
+ * never from m / f_k, so a factor of zero is handled. When m lands exactly
+ * on a cap, clamp() passes m through, and the interior derivative is used.
+ * Every factor is linear in its own weight, so df_k/dw_k does not depend on
+ * the weight. The guarded factors (recent, minutes, potential with no season
+ * baseline, b2b on a rested night) have derivative 0. */
+#define N_PARAMS 13
+#define N_FACTORS 9
+_Static_assert(sizeof(Weights) == N_PARAMS * sizeof(double), "Weights is viewed as a vector");
+
+static const char *const PARAM_NAMES[N_PARAMS] = {
+    "base_line", "base_season", "home_away", "game_total", "team_total", "def_ast",
+    "pace", "recent", "minutes", "b2b", "potential", "mult_min", "mult_max",
+};
+
+static Weights default_weights(void) {
+    return (Weights){
+        W_BASE_LINE, W_BASE_SEASON_AVG, W_HOME_AWAY, W_GAME_TOTAL, W_TEAM_TOTAL,
+        W_DEF_AST_ALLOWED, W_PACE, W_RECENT_FORM, W_MINUTES_TREND, W_BACK_TO_BACK,
+        W_POTENTIAL_AST, MULT_MIN, MULT_MAX,
+    };
+}
+
+static double *weights_vec(Weights *w) { return (double *)w; }
+
+static double rel_league_slope(double x, double avg) {
+    return avg <= 0.0 ? 0.0 : (x - avg) / avg;
+}
+
+/* Value of factor k (0 = home/away .. 8 = potential) at weight wk, given its
+ * slope d = df_k/dw_k. Only b2b is not affine: it switches off for wk <= 0. */
+static double factor_value(int k, double d, double wk) {
+    return (k == 7 && wk <= 0.0) ? 1.0 : 1.0 + d * wk;
+}
+
+/* Slopes d[k] and values f[k] of the nine factors of row i under w. */
+static void row_factors(const Weights *w, const InputsSoA *in, size_t i, double *f, double *d) {
+    double season = in->season_avg_ast[i], smin = in->season_avg_minutes[i];
+
+    d[0] = in->is_home[i] ? 1.0 : -1.0;
+    d[1] = rel_league_slope(in->game_total_ou[i], LEAGUE_AVG_GAME_TOTAL);
+    d[2] = rel_league_slope(in->team_total_ou[i], LEAGUE_AVG_TEAM_TOTAL);
+    d[3] = rel_league_slope(in->opp_ast_allowed[i], LEAGUE_AVG_AST_ALLOWED);
+    d[4] = rel_league_slope(in->matchup_pace[i], LEAGUE_AVG_PACE);
+    d[5] = season > 0.0 ? (in->recent_avg_ast[i] - season) / season : 0.0;
+    d[6] = smin > 0.0 ? (in->expected_minutes[i] - smin) / smin : 0.0;
+    d[7] = in->is_back_to_back[i] ? -1.0 : 0.0;
+    d[8] = season > 0.0
+         ? (in->last5_potential_ast[i] * in->last5_conversion[i] - season) / season : 0.0;
+    const double *wv = (const double *)w + 2;   /* home_away .. potential */
+    for (int k = 0; k < N_FACTORS; ++k) f[k] = factor_value(k, d[k], wv[k]);
+}
+
+/* Projection of row i under w; grad receives N_PARAMS partials. */
+static double project_grad_row(const Weights *w, const InputsSoA *in, size_t i, double *grad) {
+    double line = in->line_ast[i], season = in->season_avg_ast[i];
+    double f[N_FACTORS], d[N_FACTORS];
+    row_factors(w, in, i, f, d);
+
+    double pre[N_FACTORS + 1], suf[N_FACTORS];
+    pre[0] = 1.0;
+    for (int k = 0; k < N_FACTORS; ++k) pre[k + 1] = pre[k] * f[k];
+    suf[N_FACTORS - 1] = 1.0;
+    for (int k = N_FACTORS - 1; k > 0; --k) suf[k - 1] = f[k] * suf[k];
+
+    double m = pre[N_FACTORS];
+    double c = clamp(m, w->mult_min, w->mult_max);
+    double base = w->base_line * line + w->base_season * season;
+    int below = m < w->mult_min, above = !below && m > w->mult_max;
+
+    grad[0] = line * c;
+    grad[1] = season * c;
+    for (int k = 0; k < N_FACTORS; ++k)
+        grad[2 + k] = (below || above) ? 0.0 : base * (pre[k] * suf[k]) * d[k];
+    grad[11] = below ? base : 0.0;
+    grad[12] = above ? base : 0.0;
+    return base * c;
+}
+
+/* Rows [lo, hi) into proj[0..] and grad[j][0..]. */
+typedef void (*GradKernel)(const Weights *w, const InputsSoA *in, size_t lo, size_t hi,
+                           double *proj, double *const *grad);
+
+static void project_grad_range(const Weights *w, const InputsSoA *in, size_t lo, size_t hi,
+                               double *proj, double *const *grad) {
+    double g[N_PARAMS];
+    for (size_t i = lo; i < hi; ++i) {
+        proj[i - lo] = project_grad_row(w, in, i, g);
+        for (int j = 0; j < N_PARAMS; ++j) grad[j][i - lo] = g[j];
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+/* project_grad_row() four rows at a time, same operations in the same order. */
+SIMD_KERNEL("avx2")
+static void project_grad_avx2(const Weights *w, const InputsSoA *in, size_t lo, size_t hi,
+                              double *proj, double *const *grad) {
+    const __m256d one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+    const __m256d lo_cap = _mm256_set1_pd(w->mult_min), hi_cap = _mm256_set1_pd(w->mult_max);
+    const double *wv = (const double *)w + 2;   /* home_away .. potential */
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4) {
+#define SEL(m, a, b) _mm256_blendv_pd((b), (a), (m))
+#define NONZERO_I32(p) _mm256_cmp_pd(_mm256_cvtepi32_pd( \
+            _mm_loadu_si128((const __m128i *)(p))), zero, _CMP_NEQ_UQ)
+#define REL_LEAGUE(x, avg) (avg <= 0.0 ? zero : _mm256_div_pd( \
+            _mm256_sub_pd((x), _mm256_set1_pd(avg)), _mm256_set1_pd(avg)))
+#define REL_SELF(x, ref) SEL(_mm256_cmp_pd((ref), zero, _CMP_GT_OQ), \
+            _mm256_div_pd(_mm256_sub_pd((x), (ref)), (ref)), zero)
+        __m256d line = _mm256_loadu_pd(in->line_ast + i);
+        __m256d season = _mm256_loadu_pd(in->season_avg_ast + i);
+        __m256d home = NONZERO_I32(in->is_home + i);
+        __m256d b2b = NONZERO_I32(in->is_back_to_back + i);
+        __m256d f[N_FACTORS], d[N_FACTORS];
+
+        d[0] = SEL(home, one, _mm256_set1_pd(-1.0));
+        f[0] = SEL(home, _mm256_set1_pd(1.0 + w->home_away), _mm256_set1_pd(1.0 - w->home_away));
+        d[1] = REL_LEAGUE(_mm256_loadu_pd(in->game_total_ou + i), LEAGUE_AVG_GAME_TOTAL);
+        d[2] = REL_LEAGUE(_mm256_loadu_pd(in->team_total_ou + i), LEAGUE_AVG_TEAM_TOTAL);
+        d[3] = REL_LEAGUE(_mm256_loadu_pd(in->opp_ast_allowed + i), LEAGUE_AVG_AST_ALLOWED);
+        d[4] = REL_LEAGUE(_mm256_loadu_pd(in->matchup_pace + i), LEAGUE_AVG_PACE);
+        d[5] = REL_SELF(_mm256_loadu_pd(in->recent_avg_ast + i), season);
+        d[6] = REL_SELF(_mm256_loadu_pd(in->expected_minutes + i), _mm256_loadu_pd(in->season_avg_minutes + i));
+        d[7] = SEL(b2b, _mm256_set1_pd(-1.0), zero);
+        f[7] = w->b2b > 0.0 ? SEL(b2b, _mm256_set1_pd(1.0 - w->b2b), one) : one;
+        d[8] = REL_SELF(_mm256_mul_pd(_mm256_loadu_pd(in->last5_potential_ast + i),
+                                      _mm256_loadu_pd(in->last5_conversion + i)), season);
+        for (int k = 1; k < N_FACTORS; ++k)
+            if (k != 7) f[k] = _mm256_add_pd(one, _mm256_mul_pd(d[k], _mm256_set1_pd(wv[k])));
+
+        __m256d pre[N_FACTORS + 1], suf[N_FACTORS];
+        pre[0] = one;
+        for (int k = 0; k < N_FACTORS; ++k) pre[k + 1] = _mm256_mul_pd(pre[k], f[k]);
+        suf[N_FACTORS - 1] = one;
+        for (int k = N_FACTORS - 1; k > 0; --k) suf[k - 1] = _mm256_mul_pd(f[k], suf[k]);
+
+        __m256d m = pre[N_FACTORS];
+        __m256d below = _mm256_cmp_pd(m, lo_cap, _CMP_LT_OQ);
+        __m256d above = _mm256_andnot_pd(below, _mm256_cmp_pd(m, hi_cap, _CMP_GT_OQ));
+        __m256d inside = _mm256_andnot_pd(_mm256_or_pd(below, above),
+                                          _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        __m256d c = SEL(above, hi_cap, m);
+        c = SEL(below, lo_cap, c);
+        __m256d base = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(w->base_line), line),
+                                     _mm256_mul_pd(_mm256_set1_pd(w->base_season), season));
+
+        size_t o = i - lo;
+        _mm256_storeu_pd(proj + o, _mm256_mul_pd(base, c));
+        _mm256_storeu_pd(grad[0] + o, _mm256_mul_pd(line, c));
+        _mm256_storeu_pd(grad[1] + o, _mm256_mul_pd(season, c));
+        for (int k = 0; k < N_FACTORS; ++k)
+            _mm256_storeu_pd(grad[2 + k] + o, _mm256_and_pd(inside, _mm256_mul_pd(
+                _mm256_mul_pd(base, _mm256_mul_pd(pre[k], suf[k])), d[k])));
+        _mm256_storeu_pd(grad[11] + o, _mm256_and_pd(below, base));
+        _mm256_storeu_pd(grad[12] + o, _mm256_and_pd(above, base));
+#undef REL_SELF
+#undef REL_LEAGUE
+#undef NONZERO_I32
+#undef SEL
+    }
+    _mm256_zeroupper();
+    if (i < hi) {
+        double *tail[N_PARAMS];
+        for (int j = 0; j < N_PARAMS; ++j) tail[j] = grad[j] + (i - lo);
+        project_grad_range(w, in, i, hi, proj + (i - lo), tail);
+    }
+}
+#endif
+
+/* AVX2 unless the active batch kernel is narrower (or --kernel forced one). */
+static GradKernel grad_kernel(void) {
+#ifdef HAVE_X86_KERNELS
+    if (!active_kernel) kernel_select(NULL);
+    if (strcmp(active_kernel->name, "avx512") == 0 || strcmp(active_kernel->name, "avx2") == 0)
+        return project_grad_avx2;
+#endif
+    return project_grad_range;
+}
+
+/* Columnar gradients: each row's projection and its 13 derivatives. */
+typedef struct {
+    size_t n;
+    double *projection;
+    double *grad[N_PARAMS];
+    void *block;
+} GradSoA;
+
+static int grad_soa_alloc(GradSoA *s, size_t n) {
+    void **cols[N_PARAMS + 1];
+    size_t elem[N_PARAMS + 1];
+    cols[0] = (void **)&s->projection;
+    for (int j = 0; j < N_PARAMS; ++j) cols[j + 1] = (void **)&s->grad[j];
+    for (int j = 0; j <= N_PARAMS; ++j) elem[j] = sizeof(double);
+    s->block = soa_carve(n, elem, cols, N_PARAMS + 1);
+    s->n = s->block ? n : 0;
+    return s->block ? 0 : -1;
+}
+
+static void grad_soa_free(GradSoA *s) {
+    free(s->block);
+    memset(s, 0, sizeof *s);
+}
+
+/* Rows [lo, hi) of `in` into rows 0..hi-lo of `out`. */
+static void project_batch_grad(const Weights *w, const InputsSoA *in, size_t lo, size_t hi,
+                               GradSoA *out) {
+    grad_kernel()(w, in, lo, hi, out->projection, out->grad);
+}
+
+/*======================== WEIGHT FITTING ========================*/
+/* Fits the Weights vector to historical rows with known assists by
+ * minimizing a loss with projected Adam, using the analytic gradients above.
+ *
+ * Loss and gradient are summed over FIT_CHUNK-row tasks on the thread pool.
+ * Each task writes its own partial and the partials are merged in task
+ * order, so a fit is reproducible regardless of thread count. */
+
+/* Box each parameter is projected back into after every step. */
+static const double PARAM_LO[N_PARAMS] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0.30, 1.00 };
+static const double PARAM_HI[N_PARAMS] = { 1.5, 1.5, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.00, 3.00 };
+
+#define FIT_CHUNK 2048
+
+typedef enum { LOSS_MAE, LOSS_RMSE, LOSS_POISSON, LOSS_PINBALL } LossKind;
+
+typedef struct {
+    LossKind kind;
+    double tau;                  /* pinball quantile */
+} Loss;
+
+/* "mae", "rmse", "poisson", "pinball" or "pinball:TAU" (default 0.5). */
+static int parse_loss(const char *s, Loss *l) {
+    l->tau = 0.5;
+    if (strcmp(s, "mae") == 0)     { l->kind = LOSS_MAE; return 0; }
+    if (strcmp(s, "rmse") == 0)    { l->kind = LOSS_RMSE; return 0; }
+    if (strcmp(s, "poisson") == 0) { l->kind = LOSS_POISSON; return 0; }
+    if (strncmp(s, "pinball", 7) == 0) {
+        l->kind = LOSS_PINBALL;
+        if (s[7] == 0) return 0;
+        if (s[7] != ':') return -1;
+        char *end;
+        l->tau = strtod(s + 8, &end);
+        return *end == 0 && l->tau > 0.0 && l->tau < 1.0 ? 0 : -1;
+    }
+    return -1;
+}
+
+/* Per-row loss term and its derivative in the projection. For RMSE this is
+ * the squared error; loss_finish() takes the root of the mean. */
+static double loss_point(const Loss *l, double p, double y, double *dldp) {
+    switch (l->kind) {
+    case LOSS_MAE:
+        *dldp = p > y ? 1.0 : (p < y ? -1.0 : 0.0);
+        return fabs(p - y);
+    case LOSS_RMSE:
+        *dldp = 2.0 * (p - y);
+        return (p - y) * (p - y);
+    case LOSS_POISSON: {
+        if (p < 1e-9) p = 1e-9;
+        *dldp = 2.0 * (1.0 - y / p);
+        return 2.0 * ((y > 0.0 ? y * log(y / p) : 0.0) - (y - p));
+    }
+    case LOSS_PINBALL: {
+        double u = y - p;
+        *dldp = u > 0.0 ? -l->tau : 1.0 - l->tau;
+        return u >= 0.0 ? l->tau * u : (l->tau - 1.0) * u;
+    }
+    }
+    *dldp = 0.0;
+    return 0.0;
+}
+
+/* Turns summed point losses/gradients over n rows into the reported loss.
+ * grad may be NULL when only the loss is wanted. */
+static double loss_finish(const Loss *l, double sum, double *grad, size_t n) {
+    double mean = n ? sum / (double)n : 0.0;
+    for (int j = 0; grad && j < N_PARAMS; ++j) grad[j] = n ? grad[j] / (double)n : 0.0;
+    if (l->kind != LOSS_RMSE) return mean;
+    double rmse = sqrt(mean);
+    for (int j = 0; grad && j < N_PARAMS; ++j) grad[j] = rmse > 0.0 ? grad[j] / (2.0 * rmse) : 0.0;
+    return rmse;
+}
+
+typedef struct {
+    double loss;
+    double grad[N_PARAMS];
+} FitPartial;
+
+typedef struct {
+    const InputsSoA *in;
+    const double *actual;
+    const Loss *loss;
+    Weights w;
+    GradSoA *scratch;            /* FIT_CHUNK rows per worker */
+    FitPartial *parts;           /* one per task */
+} FitJob;
+
+static void fit_task(void *ctx, size_t task, int worker) {
+    FitJob *job = ctx;
+    size_t lo = task * FIT_CHUNK;
+    size_t hi = lo + FIT_CHUNK < job->in->n ? lo + FIT_CHUNK : job->in->n;
+    GradSoA *g = &job->scratch[worker];
+    FitPartial *part = &job->parts[task];
+    memset(part, 0, sizeof *part);
+
+    project_batch_grad(&job->w, job->in, lo, hi, g);
+    for (size_t i = lo; i < hi; ++i) {
+        double dldp;
+        part->loss += loss_point(job->loss, g->projection[i - lo], job->actual[i], &dldp);
+        if (dldp == 0.0) continue;
+        for (int j = 0; j < N_PARAMS; ++j) part->grad[j] += dldp * g->grad[j][i - lo];
+    }
+}
+
+/* Loss of `w` over the history, and its gradient into grad. */
+static double fit_eval(ThreadPool *pool, FitJob *job, const Weights *w, double *grad) {
+    size_t ntasks = (job->in->n + FIT_CHUNK - 1) / FIT_CHUNK;
+    job->w = *w;
+    pool_run(pool, ntasks, fit_task, job);
+
+    double sum = 0.0;
+    for (int j = 0; j < N_PARAMS; ++j) grad[j] = 0.0;
+    for (size_t t = 0; t < ntasks; ++t) {
+        sum += job->parts[t].loss;
+        for (int j = 0; j < N_PARAMS; ++j) grad[j] += job->parts[t].grad[j];
+    }
+    return loss_finish(job->loss, sum, grad, job->in->n);
+}
+
+typedef struct {
+    int iters;
+    double lr;
+    Loss loss;
+} FitOptions;
+
+static void fit_job_free(FitJob *job, int nworkers) {
+    for (int t = 0; job->scratch && t < nworkers; ++t) grad_soa_free(&job->scratch[t]);
+    free(job->scratch);
+    free(job->parts);
+}
+
+/* Projected Adam from `*w`; leaves the best weights seen in `*w`.
+ * Returns the best loss, or -1 on allocation failure. */
+static double fit_weights(ThreadPool *pool, const InputsSoA *in, const double *actual,
+                          const FitOptions *opt, Weights *w, double *start_loss) {
+    size_t ntasks = (in->n + FIT_CHUNK - 1) / FIT_CHUNK;
+    FitJob job = { in, actual, &opt->loss, *w,
+                   calloc((size_t)pool->nthreads, sizeof(GradSoA)),
+                   calloc(ntasks ? ntasks : 1, sizeof(FitPartial)) };
+    int ok = job.scratch && job.parts;
+    for (int t = 0; ok && t < pool->nthreads; ++t)
+        ok = grad_soa_alloc(&job.scratch[t], FIT_CHUNK) == 0;
+    if (!ok) {
+        fit_job_free(&job, pool->nthreads);
+        return -1.0;
+    }
+
+    const double b1 = 0.9, b2 = 0.999, eps = 1e-8;
+    double m[N_PARAMS] = {0}, v[N_PARAMS] = {0}, grad[N_PARAMS];
+    Weights cur = *w, best = *w;
+    double best_loss = fit_eval(pool, &job, &cur, grad);
+    *start_loss = best_loss;
+
+    for (int it = 1; it <= opt->iters; ++it) {
+        double *x = weights_vec(&cur);
+        for (int j = 0; j < N_PARAMS; ++j) {
+            m[j] = b1 * m[j] + (1.0 - b1) * grad[j];
+            v[j] = b2 * v[j] + (1.0 - b2) * grad[j] * grad[j];
+            double mh = m[j] / (1.0 - pow(b1, it)), vh = v[j] / (1.0 - pow(b2, it));
+            x[j] -= opt->lr * mh / (sqrt(vh) + eps);
+            x[j] = clamp(x[j], PARAM_LO[j], PARAM_HI[j]);
+        }
+        if (cur.mult_min > cur.mult_max) cur.mult_min = cur.mult_max;
+
+        double l = fit_eval(pool, &job, &cur, grad);
+        if (l < best_loss) { best_loss = l; best = cur; }
+        if (it % 50 == 0 || it == opt->iters)
+            fprintf(stderr, "iter %4d  loss %.6f  best %.6f\n", it, l, best_loss);
+    }
+    fit_job_free(&job, pool->nthreads);
+    *w = best;
+    return best_loss;
+}
+
+/*======================== SLATE ========================*/
+/* A night's worth of players. Names are interned in the slate's table, so
+ * rows carry a dense player_id and every name goes away in slate_free(). */
+typedef struct {
+    Inputs *in;
+    size_t n, cap;
+    StrTab names;
+} Slate;
+
+static int slate_reserve(Slate *s, size_t cap) {
+    if (cap <= s->cap) return 0;
+    Inputs *in = realloc(s->in, cap * sizeof *in);
+    if (!in) return -1;
+    s->in = in;
+    s->cap = cap;
+    return 0;
+}
+
+/* Copies the row, interning its name (row->player_name may be transient). */
+static int slate_push(Slate *s, const Inputs *row) {
+    if (s->n == s->cap && slate_reserve(s, s->cap ? s->cap * 2 : 64) != 0) return -1;
+    const char *name = row->player_name ? row->player_name : "";
+    uint32_t id = strtab_intern(&s->names, name, strlen(name));
+    if (id == STRTAB_NONE) return -1;
+    s->in[s->n] = *row;
+    s->in[s->n].player_id = id;
+    s->in[s->n].team_id = STRTAB_NONE;
+    s->in[s->n].player_name = strtab_name(&s->names, id);
+    s->n++;
+    return 0;
+}
+
+static void slate_free(Slate *s) {
+    free(s->in);
+    strtab_free(&s->names);
+    memset(s, 0, sizeof *s);
+}
+
+/*======================== CSV INGESTION ========================*/
+/* Memory-mapped, header-driven CSV reader. The caller describes the struct
+ * it wants filled (CsvField: column name, type, offset); the header row
+ * decides which file column feeds which field, in any order, and columns
+ * nobody asked for are skipped. Numbers are parsed straight out of the
+ * mapping, no stdio and no copies. String cells (optionally "quoted") are
+ * handed to a callback that decides where they live. */
+typedef enum { CSV_F64, CSV_I32, CSV_I64, CSV_STR } CsvType;
+
+typedef struct {
+    const char *name;
+    CsvType type;
+    size_t offset;
+    int required;
+} CsvField;
+
+/* Stores a string cell [p, p+len) and returns the pointer to keep. */
+typedef const char *(*CsvStrFn)(void *ctx, const char *p, size_t len);
+
+#define CSV_MAX_COLS 64
+#define CSV_POPULATE_MAX ((size_t)64 << 20)   /* larger files are not prefaulted */
+
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t pos;                  /* start of the next row */
+    size_t line;                 /* line number of the next row, for errors */
+    int ncols;
+    int col_field[CSV_MAX_COLS]; /* header column -> field index, -1 = skip */
+    const CsvField *fields;
+    size_t nfields;
+    CsvStrFn on_str;
+    void *str_ctx;
+    char err[160];
+} CsvReader;
+
+static const double POW10_EXACT[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* from_chars-style decimal parser over [p, end): [+-]digits[.digits][e[+-]digits].
+ * Returns the first unconsumed character, or NULL if no number starts at p.
+ * Up to 19 significant digits with a power of ten in [-22, 22] is computed
+ * exactly (one correctly rounded multiply or divide of two exact doubles);
+ * anything longer goes through strtod, so results always match strtod. */
+static const char *parse_f64(const char *p, const char *end, double *out) {
+    const char *start = p;
+    int neg = 0, any = 0, truncated = 0, ndig = 0, exp10 = 0;
+    uint64_t mant = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) neg = *p++ == '-';
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p, any = 1) {
+        if (ndig < 19) { mant = mant * 10 + (uint64_t)(*p - '0'); ndig += mant != 0; }
+        else { exp10++; truncated = 1; }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && (unsigned)(*p - '0') < 10; ++p, any = 1) {
+            if (ndig < 19) { mant = mant * 10 + (uint64_t)(*p - '0'); ndig += mant != 0; exp10--; }
+            else truncated = 1;
+        }
+    }
+    if (!any) return NULL;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0, e = 0;
+        if (q < end && (*q == '-' || *q == '+')) eneg = *q++ == '-';
+        if (q < end && (unsigned)(*q - '0') < 10) {
+            for (; q < end && (unsigned)(*q - '0') < 10; ++q)
+                if (e < 100000) e = e * 10 + (*q - '0');
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+
+    if (!truncated && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        double v = (double)mant;
+        v = exp10 < 0 ? v / POW10_EXACT[-exp10] : v * POW10_EXACT[exp10];
+        *out = neg ? -v : v;
+        return p;
+    }
+
+    char buf[128];
+    size_t len = (size_t)(p - start);
+    if (len >= sizeof buf) len = sizeof buf - 1;
+    memcpy(buf, start, len);
+    buf[len] = 0;
+    *out = strtod(buf, NULL);
+    return p;
+}
+
+static const char *parse_i32(const char *p, const char *end, int *out) {
+    int neg = 0;
+    long v = 0;
+    if (p < end && (*p == '-' || *p == '+')) neg = *p++ == '-';
+    if (p >= end || (unsigned)(*p - '0') >= 10) return NULL;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+        if (v < 1L << 31) v = v * 10 + (*p - '0');
+    *out = (int)(neg ? -v : v);
+    return p;
+}
+
+static const char *parse_i64(const char *p, const char *end, int64_t *out) {
+    int neg = 0;
+    uint64_t v = 0;
+    if (p < end && (*p == '-' || *p == '+')) neg = *p++ == '-';
+    if (p >= end || (unsigned)(*p - '0') >= 10) return NULL;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+        if (v < (uint64_t)1 << 62) v = v * 10 + (uint64_t)(*p - '0');
+    *out = neg ? -(int64_t)v : (int64_t)v;
+    return p;
+}
+
+static void csv_trim(const char **b, const char **e) {
+    while (*b < *e && (**b == ' ' || **b == '\t')) ++*b;
+    while (*e > *b && ((*e)[-1] == ' ' || (*e)[-1] == '\t' || (*e)[-1] == '\r')) --*e;
+}
+
+/* Splits off the next cell of the row [*p, end). Quoted cells come back
+ * without their quotes; `quoted` is set when "" escapes need undoing. */
+static void csv_cell(const char **p, const char *end,
+                     const char **cb, const char **ce, int *quoted) {
+    const char *s = *p;
+    *quoted = 0;
+    while (s < end && (*s == ' ' || *s == '\t')) ++s;
+    if (s < end && *s == '"') {
+        const char *q = ++s;
+        for (;;) {
+            while (q < end && *q != '"') ++q;
+            if (q + 1 < end && q[1] == '"') { q += 2; *quoted = 1; continue; }
+            break;
+        }
+        *cb = s;
+        *ce = q;
+        s = q < end ? q + 1 : q;
+        while (s < end && *s != ',') ++s;
+    } else {
+        const char *q = s;
+        while (q < end && *q != ',') ++q;
+        *cb = s;
+        *ce = q;
+        csv_trim(cb, ce);
+        s = q;
+    }
+    *p = s < end ? s + 1 : s;
+}
+
+/* Unmaps the file; r->err survives so callers can still report it. */
+/* Drops the pages already parsed, so one pass over a large file does not
+ * keep all of it resident. */
+static void csv_release(CsvReader *r) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t done = r->pos / page * page;
+#ifdef MADV_DONTNEED
+    if (done) madvise((void *)r->data, done, MADV_DONTNEED);
+#else
+    (void)done;
+#endif
+}
+
+static void csv_close(CsvReader *r) {
+    if (r->data && r->size) munmap((void *)r->data, r->size);
+    r->data = NULL;
+    r->size = r->pos = 0;
+}
+
+/* Maps `path` and binds its header against `fields`. Returns 0, or -1 with
+ * r->err set (missing file, unknown layout, required column absent). */
+static int csv_open(CsvReader *r, const char *path, const CsvField *fields, size_t nfields,
+                    CsvStrFn on_str, void *str_ctx) {
+    memset(r, 0, sizeof *r);
+    r->fields = fields;
+    r->nfields = nfields;
+    r->on_str = on_str;
+    r->str_ctx = str_ctx;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { snprintf(r->err, sizeof r->err, "%s: %s", path, strerror(errno)); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        snprintf(r->err, sizeof r->err, "%s: empty or unreadable", path);
+        close(fd);
+        return -1;
+    }
+    /* Prefault small files in one go; large ones stream in behind the
+     * sequential-read hint so csv_release() can keep residency flat. */
+    int populate = (size_t)st.st_size <= CSV_POPULATE_MAX ? MAP_POPULATE : 0;
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | populate, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { snprintf(r->err, sizeof r->err, "%s: %s", path, strerror(errno)); return -1; }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+    r->data = map;
+    r->size = (size_t)st.st_size;
+
+    const char *p = r->data, *end = r->data + r->size;
+    if (end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) eol = end;
+
+    int seen[CSV_MAX_COLS] = {0};
+    while (p < eol || (p == eol && r->ncols == 0)) {
+        if (r->ncols == CSV_MAX_COLS) {
+            snprintf(r->err, sizeof r->err, "%s: more than %d columns", path, CSV_MAX_COLS);
+            csv_close(r);
+            return -1;
+        }
+        const char *cb, *ce;
+        int quoted;
+        csv_cell(&p, eol, &cb, &ce, &quoted);
+        int f = -1;
+        for (size_t k = 0; k < nfields; ++k)
+            if (strlen(fields[k].name) == (size_t)(ce - cb) &&
+                memcmp(fields[k].name, cb, (size_t)(ce - cb)) == 0) { f = (int)k; break; }
+        if (f >= 0 && seen[f]) f = -1;  /* first occurrence wins */
+        if (f >= 0) seen[f] = 1;
+        r->col_field[r->ncols++] = f;
+        if (p == eol) break;
+    }
+    for (size_t k = 0; k < nfields; ++k) {
+        if (fields[k].required && !seen[k]) {
+            snprintf(r->err, sizeof r->err, "%s: missing column '%s'", path, fields[k].name);
+            csv_close(r);
+            return -1;
+        }
+    }
+    r->pos = (size_t)((eol < end ? eol + 1 : end) - r->data);
+    r->line = 2;
+    return 0;
+}
+
+/* Upper bound on the rows left (one per remaining newline), for sizing
+ * the destination before a load. */
+static size_t csv_rows_hint(const CsvReader *r) {
+    size_t rows = 1;
+    const char *p = r->data + r->pos, *end = r->data + r->size;
+    while (p < end && (p = memchr(p, '\n', (size_t)(end - p))) != NULL) { ++rows; ++p; }
+    return rows;
+}
+
+/* Fills the bound fields of `row` from the next non-blank line; unbound
+ * fields are left alone, so pre-load defaults into `row`. Returns 1 for a
+ * row, 0 at end of file, -1 on a malformed row (r->err says where). */
+static int csv_next(CsvReader *r, void *row) {
+    const char *end = r->data + r->size;
+    for (;;) {
+        const char *p = r->data + r->pos;
+        if (p >= end) return 0;
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) eol = end;
+        r->pos = (size_t)((eol < end ? eol + 1 : end) - r->data);
+        size_t line = r->line++;
+
+        const char *b = p, *e = eol;
+        csv_trim(&b, &e);
+        if (b == e) continue;
+
+        for (int c = 0; c < r->ncols; ++c) {
+            if (p > eol || (p == eol && c > 0 && p[-1] != ',')) {
+                snprintf(r->err, sizeof r->err, "line %zu: %d columns, header has %d",
+                         line, c, r->ncols);
+                return -1;
+            }
+            const char *cb, *ce;
+            int quoted;
+            csv_cell(&p, eol, &cb, &ce, &quoted);
+            int f = r->col_field[c];
+            if (f < 0) continue;
+
+            const CsvField *fd = &r->fields[f];
+            char *dst = (char *)row + fd->offset;
+            const char *stop = NULL;
+            if (fd->type == CSV_F64) {
+                stop = parse_f64(cb, ce, (double *)dst);
+            } else if (fd->type == CSV_I32) {
+                stop = parse_i32(cb, ce, (int *)dst);
+            } else if (fd->type == CSV_I64) {
+                stop = parse_i64(cb, ce, (int64_t *)dst);
+            } else {
+                char unq[256];
+                size_t len = (size_t)(ce - cb);
+                if (quoted) {          /* undo "" escapes */
+                    len = 0;
+                    for (const char *q = cb; q < ce && len < sizeof unq; ++q) {
+                        unq[len++] = *q;
+                        if (*q == '"') ++q;
+                    }
+                    cb = unq;
+                }
+                *(const char **)dst = r->on_str(r->str_ctx, cb, len);
+                stop = ce;
+            }
+            if (stop != ce) {
+                snprintf(r->err, sizeof r->err, "line %zu: bad value for '%s': '%.*s'",
+                         line, fd->name, (int)(ce - cb > 40 ? 40 : ce - cb), cb);
+                return -1;
+            }
+        }
+        return 1;
+    }
+}
+
+/* Names land in a 128-byte scratch buffer; the caller interns them. */
+static const char *csv_name_scratch(void *ctx, const char *p, size_t len) {
+    char *buf = ctx;
+    if (len > 127) len = 127;
+    memcpy(buf, p, len);
+    buf[len] = 0;
+    return buf;
+}
+
+#define INPUT_FIELD(f, t) { #f, t, offsetof(Inputs, f), 1 }
+static const CsvField SLATE_FIELDS[] = {
+    INPUT_FIELD(player_name,         CSV_STR),
+    INPUT_FIELD(line_ast,            CSV_F64),
+    INPUT_FIELD(season_avg_ast,      CSV_F64),
+    INPUT_FIELD(is_home,             CSV_I32),
+    INPUT_FIELD(game_total_ou,       CSV_F64),
+    INPUT_FIELD(team_total_ou,       CSV_F64),
+    INPUT_FIELD(opp_ast_allowed,     CSV_F64),
+    INPUT_FIELD(matchup_pace,        CSV_F64),
+    INPUT_FIELD(recent_avg_ast,      CSV_F64),
+    INPUT_FIELD(season_avg_minutes,  CSV_F64),
+    INPUT_FIELD(expected_minutes,    CSV_F64),
+    INPUT_FIELD(is_back_to_back,     CSV_I32),
+    INPUT_FIELD(last5_potential_ast, CSV_F64),
+    INPUT_FIELD(last5_conversion,    CSV_F64),
+};
+#define N_SLATE_FIELDS (sizeof(SLATE_FIELDS) / sizeof(SLATE_FIELDS[0]))
+
+/*======================== .aslate COLUMNAR FILES ========================*/
+/* Binary slate format, laid out so a map of the file *is* an InputsSoA:
+ *
+ *   AslateHeader          64 bytes
+ *   AslateColumn[ncols]   directory: name, type, byte offset of each column
+ *   columns               one per Inputs field plus player_id and team_id,
+ *                         64-byte aligned
+ *   name table            uint32 offsets[nnames + 1], then NUL-terminated
+ *                         names, indexed by player_id and team_id
+ *
+ * Integers are little-endian (files are not portable to big-endian hosts).
+ * Readers bind columns by name and ignore ones they do not know, so new
+ * columns can be appended without breaking old binaries; a change to an
+ * existing column's meaning bumps ASLATE_VERSION. */
+#define ASLATE_MAGIC   "ASLATE\r\n"
+#define ASLATE_VERSION 2u       /* 2: player_id column + distinct-name table */
+
+enum { COL_F64 = 1, COL_I32 = 2, COL_U32 = 3 };
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t ncols;
+    uint64_t nrows;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint64_t file_size;
+    uint64_t nnames;
+    uint8_t reserved[8];
+} AslateHeader;
+
+typedef struct {
+    char name[32];
+    uint32_t type;
+    uint32_t elem_size;
+    uint64_t offset;
+} AslateColumn;
+
+_Static_assert(sizeof(AslateHeader) == 64, "AslateHeader is an on-disk layout");
+_Static_assert(sizeof(AslateColumn) == 48, "AslateColumn is an on-disk layout");
+
+typedef struct {
+    const char *name;
+    uint32_t type;
+    size_t soa_offset;           /* offset of the column pointer in InputsSoA */
+    int optional;                /* files from before it was added lack it */
+} SoaColumn;
+
+#define SOA_COLUMN(f, t) { #f, t, offsetof(InputsSoA, f), 0 }
+static const SoaColumn INPUT_COLUMNS[] = {
+    SOA_COLUMN(line_ast,            COL_F64),
+    SOA_COLUMN(season_avg_ast,      COL_F64),
+    SOA_COLUMN(is_home,             COL_I32),
+    SOA_COLUMN(game_total_ou,       COL_F64),
+    SOA_COLUMN(team_total_ou,       COL_F64),
+    SOA_COLUMN(opp_ast_allowed,     COL_F64),
+    SOA_COLUMN(matchup_pace,        COL_F64),
+    SOA_COLUMN(recent_avg_ast,      COL_F64),
+    SOA_COLUMN(season_avg_minutes,  COL_F64),
+    SOA_COLUMN(expected_minutes,    COL_F64),
+    SOA_COLUMN(is_back_to_back,     COL_I32),
+    SOA_COLUMN(last5_potential_ast, COL_F64),
+    SOA_COLUMN(last5_conversion,    COL_F64),
+    SOA_COLUMN(player_id,           COL_U32),
+    { "team_id", COL_U32, offsetof(InputsSoA, team_id), 1 },
+};
+#undef SOA_COLUMN
+#define N_INPUT_COLUMNS (sizeof(INPUT_COLUMNS) / sizeof(INPUT_COLUMNS[0]))
+
+static size_t col_elem_size(uint32_t type) {
+    return type == COL_F64 ? sizeof(double) : sizeof(uint32_t);
+}
+
+static void **soa_column_slot(InputsSoA *s, const SoaColumn *c) {
+    return (void **)((char *)s + c->soa_offset);
+}
+
+/* A mapped .aslate file. `view` points straight into the mapping, and
+ * `names` borrows its strings from the mapping's name table. */
+typedef struct {
+    void *map;
+    size_t size;
+    InputsSoA view;
+    StrTab names;
+} Aslate;
+
+static int write_padding(FILE *fp, uint64_t *pos, uint64_t align) {
+    static const char zeros[SOA_ALIGN];
+    uint64_t pad = (align - *pos % align) % align;
+    *pos += pad;
+    return fwrite(zeros, 1, (size_t)pad, fp) == pad ? 0 : -1;
+}
+
+static int aslate_write(const char *path, const InputsSoA *s) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) { perror(path); return -1; }
+
+    AslateHeader h = {0};
+    AslateColumn dir[N_INPUT_COLUMNS];
+    memset(dir, 0, sizeof dir);
+    memcpy(h.magic, ASLATE_MAGIC, 8);
+    h.version = ASLATE_VERSION;
+    h.ncols = (uint32_t)N_INPUT_COLUMNS;
+    h.nrows = s->n;
+
+    uint64_t pos = sizeof h + sizeof dir;
+    pos = (pos + SOA_ALIGN - 1) / SOA_ALIGN * SOA_ALIGN;
+    for (size_t c = 0; c < N_INPUT_COLUMNS; ++c) {
+        snprintf(dir[c].name, sizeof dir[c].name, "%s", INPUT_COLUMNS[c].name);
+        dir[c].type = INPUT_COLUMNS[c].type;
+        dir[c].elem_size = (uint32_t)col_elem_size(dir[c].type);
+        dir[c].offset = pos;
+        pos += soa_stride(s->n, dir[c].elem_size);
+    }
+    uint32_t nnames = s->names->count;
+    h.nnames = nnames;
+    h.names_offset = pos;
+    h.names_size = (nnames + 1) * sizeof(uint32_t);
+    for (uint32_t id = 0; id < nnames; ++id) h.names_size += strlen(s->names->names[id]) + 1;
+    h.file_size = h.names_offset + h.names_size;
+
+    int ok = fwrite(&h, sizeof h, 1, fp) == 1 && fwrite(dir, sizeof dir, 1, fp) == 1;
+    pos = sizeof h + sizeof dir;
+    for (size_t c = 0; ok && c < N_INPUT_COLUMNS; ++c) {
+        ok = write_padding(fp, &pos, SOA_ALIGN) == 0;
+        const void *col = *soa_column_slot((InputsSoA *)s, &INPUT_COLUMNS[c]);
+        size_t bytes = s->n * dir[c].elem_size;
+        if (col) {
+            ok = ok && fwrite(col, 1, bytes, fp) == bytes;
+        } else {                         /* optional column absent: all 0xff (NONE) */
+            unsigned char none[SOA_ALIGN];
+            memset(none, 0xff, sizeof none);
+            for (size_t left = bytes; ok && left; ) {
+                size_t k = left < sizeof none ? left : sizeof none;
+                ok = fwrite(none, 1, k, fp) == k;
+                left -= k;
+            }
+        }
+        pos += bytes;
+    }
+    ok = ok && write_padding(fp, &pos, SOA_ALIGN) == 0;
+
+    uint32_t off = 0;
+    for (uint32_t id = 0; ok && id <= nnames; ++id) {
+        ok = fwrite(&off, sizeof off, 1, fp) == 1;
+        if (id < nnames) off += (uint32_t)strlen(s->names->names[id]) + 1;
+    }
+    for (uint32_t id = 0; ok && id < nnames; ++id)
+        ok = fwrite(s->names->names[id], strlen(s->names->names[id]) + 1, 1, fp) == 1;
+
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) { fprintf(stderr, "%s: write failed\n", path); return -1; }
+    return 0;
+}
+
+static void aslate_close(Aslate *a) {
+    free(a->names.names);
+    if (a->map) munmap(a->map, a->size);
+    memset(a, 0, sizeof *a);
+}
+
+/* Maps `path` and checks it against the schema. Returns 0, or -1 with a
+ * message in err. */
+static int aslate_open(Aslate *a, const char *path, char *err, size_t errlen) {
+    memset(a, 0, sizeof *a);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { snprintf(err, errlen, "%s: %s", path, strerror(errno)); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AslateHeader)) {
+        snprintf(err, errlen, "%s: too short for an .aslate header", path);
+        close(fd);
+        return -1;
+    }
+    a->size = (size_t)st.st_size;
+    a->map = mmap(NULL, a->size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (a->map == MAP_FAILED) {
+        a->map = NULL;
+        snprintf(err, errlen, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    const char *base = a->map;
+    const AslateHeader *h = a->map;
+    if (memcmp(h->magic, ASLATE_MAGIC, 8) != 0) {
+        snprintf(err, errlen, "%s: not an .aslate file", path);
+        goto fail;
+    }
+    if (h->version != ASLATE_VERSION) {
+        snprintf(err, errlen, "%s: schema version %u, expected %u", path, h->version, ASLATE_VERSION);
+        goto fail;
+    }
+    if (h->file_size != a->size || h->nrows > UINT32_MAX || h->nnames > UINT32_MAX ||
+        sizeof *h + (uint64_t)h->ncols * sizeof(AslateColumn) > a->size ||
+        h->names_offset > a->size || h->names_size > a->size - h->names_offset ||
+        h->names_size < (h->nnames + 1) * sizeof(uint32_t)) {
+        snprintf(err, errlen, "%s: truncated or corrupt header", path);
+        goto fail;
+    }
+
+    size_t n = (size_t)h->nrows;
+    const AslateColumn *dir = (const AslateColumn *)(base + sizeof *h);
+    a->view.n = n;
+    for (size_t c = 0; c < N_INPUT_COLUMNS; ++c) {
+        const SoaColumn *want = &INPUT_COLUMNS[c];
+        const AslateColumn *got = NULL;
+        for (uint32_t k = 0; k < h->ncols && !got; ++k)
+            if (strncmp(dir[k].name, want->name, sizeof dir[k].name) == 0) got = &dir[k];
+        if (!got && want->optional) continue;    /* its pointer stays NULL */
+        if (!got || got->type != want->type || got->elem_size != col_elem_size(want->type) ||
+            got->offset % SOA_ALIGN != 0 || got->offset > a->size ||
+            (uint64_t)n * got->elem_size > a->size - got->offset) {
+            snprintf(err, errlen, "%s: column '%s' missing or malformed", path, want->name);
+            goto fail;
+        }
+        *soa_column_slot(&a->view, want) = (void *)(base + got->offset);
+    }
+
+    uint32_t nnames = (uint32_t)h->nnames;
+    const uint32_t *offs = (const uint32_t *)(base + h->names_offset);
+    const char *bytes = (const char *)(offs + nnames + 1);
+    uint64_t nbytes = h->names_size - (nnames + 1) * (uint64_t)sizeof(uint32_t);
+    a->names.names = malloc((nnames ? nnames : 1) * sizeof *a->names.names);
+    if (!a->names.names) { snprintf(err, errlen, "%s: out of memory", path); goto fail; }
+    for (uint32_t id = 0; id < nnames; ++id) {
+        if (offs[id] > offs[id + 1] || offs[id + 1] > nbytes || offs[id + 1] == offs[id] ||
+            bytes[offs[id + 1] - 1] != 0) {
+            snprintf(err, errlen, "%s: corrupt name table at id %u", path, id);
+            goto fail;
+        }
+        a->names.names[id] = bytes + offs[id];
+    }
+    a->names.count = a->names.cap = nnames;
+    for (size_t i = 0; i < n; ++i) {
+        if (a->view.player_id[i] >= nnames ||
+            (a->view.team_id && a->view.team_id[i] >= nnames && a->view.team_id[i] != STRTAB_NONE)) {
+            snprintf(err, errlen, "%s: row %zu has player_id or team_id out of range", path, i);
+            goto fail;
+        }
+    }
+    a->view.names = &a->names;
+    return 0;
+
+fail:
+    aslate_close(a);
+    return -1;
+}
+
+/*======================== GAME-LOG FEATURES ========================*/
+/* Derives the player-form inputs (season_avg_ast, season_avg_minutes,
+ * recent_avg_ast, last5_potential_ast, last5_conversion) from box-score
+ * game logs instead of hand entry. Each player keeps a PlayerForm: a ring
+ * of the last FORM_WINDOW games plus running sums for the two windows, so
+ * a new game is O(1) (add it, subtract the games that fall out of each
+ * window) no matter how much history sits behind it.
+ *
+ * Alongside the windows each record carries exponentially weighted sums
+ * (decay 2^(-1/half_life) per game), which avoid the jump when a big game
+ * drops out of a window. form_fill() emits either set (FormMode):
+ *   window  recent_avg_ast = last-10 mean, last5_* over the last 5 games
+ *   ewma    recent_avg_ast and last5_potential_ast = weighted means,
+ *           last5_conversion = weighted assists / weighted potential
+ * The half-life is baked into the sums, so it is fixed when a state file
+ * is created and recorded in its header.
+ *
+ * The state persists in an .aform file, so a nightly refresh only applies
+ * that night's log to the saved state and never rescans the season:
+ *
+ *   AformHeader          40 bytes
+ *   PlayerForm[n]        indexed by player id
+ *   name table           uint32 offsets[n + 1], then NUL-terminated names
+ *
+ * Integers are little-endian, as in .aslate. A game dated on or before
+ * the player's newest applied game is skipped, so re-applying a log is
+ * harmless. A new season resets the player. */
+#define FORM_WINDOW 10           /* recent_avg_ast: last FORM_WINDOW games */
+#define FORM_LAST5  5            /* last5_potential_ast, last5_conversion */
+
+#define FORM_HALF_LIFE 5.0        /* default EWMA half-life, in games */
+
+#define AFORM_MAGIC   "AFORM\0\0\0"
+#define AFORM_VERSION 2u         /* 2: EWMA sums and half_life */
+
+typedef enum { FORM_MODE_WINDOW, FORM_MODE_EWMA } FormMode;
+
+typedef struct {
+    int32_t season;              /* season of the games below */
+    int32_t last_date;           /* yyyymmdd of the newest game applied */
+    uint32_t games;              /* games this season */
+    uint32_t head;               /* ring slot the next game goes to */
+    double season_ast, season_min;
+    double sum_ast_window;       /* assists over the last FORM_WINDOW games */
+    double sum_ast5, sum_pot5;   /* assists and potential assists, last FORM_LAST5 */
+    double ring_ast[FORM_WINDOW];
+    double ring_pot[FORM_WINDOW];
+    double ewma_w;               /* sum of decay^age: normalizes the two below */
+    double ewma_ast, ewma_pot;   /* sum of decay^age * value */
+} PlayerForm;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t nplayers;
+    uint32_t window, last5;      /* ring geometry the records were built with */
+    uint32_t record_size;
+    uint32_t reserved;
+    double half_life;            /* EWMA half-life the sums were built with */
+} AformHeader;
+
+typedef struct {
+    StrTab names;                /* player id -> name */
+    PlayerForm *form;            /* indexed by player id */
+    uint32_t cap;
+    double half_life, decay;
+    FormMode mode;               /* which features form_fill_slate() emits */
+} FormStore;
+
+/* One box-score line. final_ts (yyyymmddHHMM, optional) is when the game
+ * went final; only the as-of join reads it. */
+typedef struct {
+    const char *player_name;
+    int season;
+    int game_date;
+    double ast;
+    double potential_ast;
+    double minutes;
+    int64_t final_ts;
+} GameLogRow;
+
+#define LOG_FIELD(f, t) { #f, t, offsetof(GameLogRow, f), 1 }
+static const CsvField GAME_LOG_FIELDS[] = {
+    LOG_FIELD(player_name,   CSV_STR),
+    LOG_FIELD(season,        CSV_I32),
+    LOG_FIELD(game_date,     CSV_I32),
+    LOG_FIELD(ast,           CSV_F64),
+    LOG_FIELD(potential_ast, CSV_F64),
+    LOG_FIELD(minutes,       CSV_F64),
+    { "final_ts", CSV_I64, offsetof(GameLogRow, final_ts), 0 },
+};
+#define N_GAME_LOG_FIELDS (sizeof(GAME_LOG_FIELDS) / sizeof(GAME_LOG_FIELDS[0]))
+
+static void form_store_free(FormStore *s) {
+    strtab_free(&s->names);
+    free(s->form);
+    memset(s, 0, sizeof *s);
+}
+
+/* The record for `name`, created empty if new; NULL on OOM. */
+static PlayerForm *form_store_get(FormStore *s, const char *name, size_t len) {
+    uint32_t id = strtab_intern(&s->names, name, len);
+    if (id == STRTAB_NONE) return NULL;
+    if (id >= s->cap) {
+        uint32_t cap = s->cap ? s->cap * 2 : 256;
+        while (cap <= id) cap *= 2;
+        PlayerForm *f = realloc(s->form, cap * sizeof *f);
+        if (!f) return NULL;
+        memset(f + s->cap, 0, (cap - s->cap) * sizeof *f);
+        s->form = f;
+        s->cap = cap;
+    }
+    return &s->form[id];
+}
+
+/* Existing record for `name`, or NULL. */
+static const PlayerForm *form_store_find(const FormStore *s, const char *name) {
+    uint32_t id = strtab_find(&s->names, name);
+    return id == STRTAB_NONE ? NULL : &s->form[id];
+}
+
+static int parse_form_mode(const char *s, FormMode *m) {
+    if (strcmp(s, "window") == 0) *m = FORM_MODE_WINDOW;
+    else if (strcmp(s, "ewma") == 0) *m = FORM_MODE_EWMA;
+    else return -1;
+    return 0;
+}
+
+static void form_store_set_half_life(FormStore *s, double half_life) {
+    s->half_life = half_life;
+    s->decay = exp2(-1.0 / half_life);
+}
+
+/* Applies one game. A later season starts the player over. Returns 0 if
+ * the game is older than the player's state (an earlier season, or on or
+ * before the newest game applied). */
+static int form_push(PlayerForm *f, const GameLogRow *g, double decay) {
+    if (f->games && g->season < f->season) return 0;
+    if (f->games && g->season > f->season) memset(f, 0, sizeof *f);
+    else if (f->games && g->game_date <= f->last_date) return 0;
+    f->season = g->season;
+    f->last_date = g->game_date;
+
+    uint32_t h = f->head;
+    if (f->games >= FORM_WINDOW) f->sum_ast_window -= f->ring_ast[h];
+    if (f->games >= FORM_LAST5) {
+        uint32_t out = (h + FORM_WINDOW - FORM_LAST5) % FORM_WINDOW;
+        f->sum_ast5 -= f->ring_ast[out];
+        f->sum_pot5 -= f->ring_pot[out];
+    }
+    f->ring_ast[h] = g->ast;
+    f->ring_pot[h] = g->potential_ast;
+    f->sum_ast_window += g->ast;
+    f->sum_ast5 += g->ast;
+    f->sum_pot5 += g->potential_ast;
+    f->head = (h + 1) % FORM_WINDOW;
+    f->games++;
+    f->season_ast += g->ast;
+    f->season_min += g->minutes;
+    f->ewma_w   = decay * f->ewma_w + 1.0;
+    f->ewma_ast = decay * f->ewma_ast + g->ast;
+    f->ewma_pot = decay * f->ewma_pot + g->potential_ast;
+    return 1;
+}
+
+/* Writes the form fields of `in` from the player's state. */
+static void form_fill(const PlayerForm *f, FormMode mode, Inputs *in) {
+    if (!f->games) return;
+    in->season_avg_ast     = f->season_ast / f->games;
+    in->season_avg_minutes = f->season_min / f->games;
+    if (mode == FORM_MODE_EWMA) {
+        in->recent_avg_ast      = f->ewma_ast / f->ewma_w;
+        in->last5_potential_ast = f->ewma_pot / f->ewma_w;
+        in->last5_conversion    = f->ewma_pot > 0.0 ? f->ewma_ast / f->ewma_pot : 0.0;
+        return;
+    }
+    double n = f->games < FORM_WINDOW ? f->games : FORM_WINDOW;
+    double n5 = f->games < FORM_LAST5 ? f->games : FORM_LAST5;
+    in->recent_avg_ast      = f->sum_ast_window / n;
+    in->last5_potential_ast = f->sum_pot5 / n5;
+    in->last5_conversion    = f->sum_pot5 > 0.0 ? f->sum_ast5 / f->sum_pot5 : 0.0;
+}
+
+/* The Inputs fields form_fill() writes. A slate run with --form may omit
+ * these columns; rows load with NAN there until the state fills them. */
+static const size_t FORM_INPUT_OFFSETS[] = {
+    offsetof(Inputs, season_avg_ast), offsetof(Inputs, season_avg_minutes),
+    offsetof(Inputs, recent_avg_ast), offsetof(Inputs, last5_potential_ast),
+    offsetof(Inputs, last5_conversion),
+};
+#define N_FORM_INPUTS (sizeof(FORM_INPUT_OFFSETS) / sizeof(FORM_INPUT_OFFSETS[0]))
+
+static int is_form_input(size_t offset) {
+    for (size_t k = 0; k < N_FORM_INPUTS; ++k)
+        if (FORM_INPUT_OFFSETS[k] == offset) return 1;
+    return 0;
+}
+
+/* Fills the form fields of every slate row whose player has state. A row
+ * left with a NAN field (no state and no column) is an error. */
+static int form_fill_slate(const FormStore *s, Slate *slate) {
+    for (size_t i = 0; i < slate->n; ++i) {
+        Inputs *in = &slate->in[i];
+        const PlayerForm *f = form_store_find(s, in->player_name);
+        if (f) form_fill(f, s->mode, in);
+        for (size_t k = 0; k < N_FORM_INPUTS; ++k) {
+            if (isnan(*(const double *)((const char *)in + FORM_INPUT_OFFSETS[k]))) {
+                fprintf(stderr, "no game log for '%s' and no form columns in the slate\n",
+                        in->player_name);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Loads `path` into an empty store. A missing file is an empty store with
+ * the given half-life (<= 0: FORM_HALF_LIFE), so the first update starts
+ * from scratch. An existing file keeps its own half-life; asking for a
+ * different one is an error. Returns 0, or -1 with a message. */
+static int form_store_load(FormStore *s, const char *path, double half_life) {
+    memset(s, 0, sizeof *s);
+    form_store_set_half_life(s, half_life > 0.0 ? half_life : FORM_HALF_LIFE);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        if (errno == ENOENT) return 0;
+        perror(path);
+        return -1;
+    }
+    AformHeader h;
+    uint32_t *offs = NULL;
+    char *bytes = NULL;
+    int ok = fread(&h, sizeof h, 1, fp) == 1 && memcmp(h.magic, AFORM_MAGIC, 8) == 0;
+    if (ok && (h.version != AFORM_VERSION || h.window != FORM_WINDOW || h.last5 != FORM_LAST5 ||
+               h.record_size != sizeof(PlayerForm))) {
+        fprintf(stderr, "%s: form state version %u (window %u/%u), expected %u (%d/%d)\n",
+                path, h.version, h.window, h.last5, AFORM_VERSION, FORM_WINDOW, FORM_LAST5);
+        fclose(fp);
+        return -1;
+    }
+    if (ok && !(h.half_life > 0.0)) ok = 0;
+    if (ok && half_life > 0.0 && half_life != h.half_life) {
+        fprintf(stderr, "%s: built with half-life %g, not %g; rebuild it from the season's logs\n",
+                path, h.half_life, half_life);
+        fclose(fp);
+        return -1;
+    }
+    if (ok) form_store_set_half_life(s, h.half_life);
+    if (ok && h.nplayers) {
+        s->cap = h.nplayers;
+        s->form = malloc(h.nplayers * sizeof *s->form);
+        offs = malloc((h.nplayers + 1) * sizeof *offs);
+        ok = s->form && offs &&
+             fread(s->form, sizeof *s->form, h.nplayers, fp) == h.nplayers &&
+             fread(offs, sizeof *offs, h.nplayers + 1, fp) == h.nplayers + 1 &&
+             offs[0] == 0 && (bytes = malloc(offs[h.nplayers] + 1)) != NULL &&
+             fread(bytes, 1, offs[h.nplayers], fp) == offs[h.nplayers];
+        for (uint32_t id = 0; ok && id < h.nplayers; ++id) {
+            ok = offs[id] < offs[id + 1] && offs[id + 1] <= offs[h.nplayers] &&
+                 bytes[offs[id + 1] - 1] == 0 &&
+                 strtab_intern(&s->names, bytes + offs[id], offs[id + 1] - offs[id] - 1) == id;
+        }
+    }
+    fclose(fp);
+    free(offs);
+    free(bytes);
+    if (!ok) {
+        fprintf(stderr, "%s: truncated or corrupt form state\n", path);
+        form_store_free(s);
+        return -1;
+    }
+    return 0;
+}
+
+/* Writes the store to path.tmp and renames it over `path`, so a crash
+ * mid-write leaves the previous night's state intact. */
+static int form_store_save(const FormStore *s, const char *path) {
+    size_t plen = strlen(path);
+    char *tmp = malloc(plen + 5);
+    if (!tmp) return -1;
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) { perror(tmp); free(tmp); return -1; }
+
+    uint32_t n = s->names.count;
+    AformHeader h = {0};
+    memcpy(h.magic, AFORM_MAGIC, 8);
+    h.version = AFORM_VERSION;
+    h.nplayers = n;
+    h.window = FORM_WINDOW;
+    h.last5 = FORM_LAST5;
+    h.record_size = sizeof(PlayerForm);
+    h.half_life = s->half_life;
+    int ok = fwrite(&h, sizeof h, 1, fp) == 1 && fwrite(s->form, sizeof *s->form, n, fp) == n;
+    uint32_t off = 0;
+    for (uint32_t id = 0; ok && id <= n; ++id) {
+        ok = fwrite(&off, sizeof off, 1, fp) == 1;
+        if (id < n) off += (uint32_t)strlen(s->names.names[id]) + 1;
+    }
+    for (uint32_t id = 0; ok && id < n; ++id)
+        ok = fwrite(s->names.names[id], strlen(s->names.names[id]) + 1, 1, fp) == 1;
+    if (fclose(fp) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) { perror(path); ok = 0; }
+    if (!ok) { fprintf(stderr, "%s: write failed\n", tmp); remove(tmp); }
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+/* Applies every game in the log at `path`, which must be in date order per
+ * player. Counts go to *applied and *skipped. Returns 0 or -1. */
+static int form_store_apply_log(FormStore *s, const char *path, size_t *applied, size_t *skipped) {
+    CsvReader r;
+    GameLogRow row;
+    char namebuf[128];
+    if (csv_open(&r, path, GAME_LOG_FIELDS, N_GAME_LOG_FIELDS, csv_name_scratch, namebuf) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return -1;
+    }
+    int rc;
+    while ((rc = csv_next(&r, &row)) == 1) {
+        PlayerForm *f = form_store_get(s, namebuf, strlen(namebuf));
+        if (!f) { fprintf(stderr, "out of memory after %u players\n", s->names.count); rc = -1; break; }
+        if (form_push(f, &row, s->decay)) ++*applied;
+        else ++*skipped;
+    }
+    if (rc < 0 && r.err[0]) fprintf(stderr, "%s: %s\n", path, r.err);
+    csv_close(&r);
+    return rc < 0 ? -1 : 0;
+}
+
+/*======================== BUFFERED OUTPUT ========================*/
+/* Fixed buffer in front of a file descriptor. Callers format straight into
+ * ob_reserve()'d space; nothing is allocated per record. */
+typedef struct {
+    int fd;
+    int failed;
+    size_t len;
+    char buf[1 << 16];
+} OutBuf;
+
+static void ob_flush(OutBuf *ob) {
+    size_t off = 0;
+    while (off < ob->len && !ob->failed) {
+        ssize_t w = write(ob->fd, ob->buf + off, ob->len - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { ob->failed = 1; break; }
+        off += (size_t)w;
+    }
+    ob->len = 0;
+}
+
+/* Returns room for at least n bytes (n must fit the buffer). */
+static char *ob_reserve(OutBuf *ob, size_t n) {
+    if (sizeof ob->buf - ob->len < n) ob_flush(ob);
+    return ob->buf + ob->len;
+}
+
+static void ob_write(OutBuf *ob, const char *s, size_t n) {
+    if (n <= sizeof ob->buf - ob->len) {
+        memcpy(ob->buf + ob->len, s, n);
+        ob->len += n;
+        return;
+    }
+    while (n) {
+        size_t room = sizeof ob->buf - ob->len;
+        if (room == 0) { ob_flush(ob); room = sizeof ob->buf; }
+        size_t k = n < room ? n : room;
+        memcpy(ob->buf + ob->len, s, k);
+        ob->len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+static void ob_puts(OutBuf *ob, const char *s) { ob_write(ob, s, strlen(s)); }
+
+/*------------------------ shortest round-trip doubles ------------------------*/
+/* Grisu2 (Loitsch 2010): digits that read back to the same double, almost
+ * always the shortest such string, from 64-bit integer math and one table
+ * of cached powers of ten, 10^k for k = -348, -340, ..., 340. */
+static const uint64_t GRISU_POW10_F[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const int16_t GRISU_POW10_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+typedef struct { uint64_t f; int e; } DiyFp;
+
+static DiyFp diyfp_mul(DiyFp a, DiyFp b) {
+    unsigned __int128 p = (unsigned __int128)a.f * b.f;
+    uint64_t hi = (uint64_t)(p >> 64);
+    if ((uint64_t)p & (1ULL << 63)) ++hi;          /* round */
+    return (DiyFp){ hi, a.e + b.e + 64 };
+}
+
+static DiyFp diyfp_normalize(DiyFp a) {
+    int s = __builtin_clzll(a.f);
+    return (DiyFp){ a.f << s, a.e - s };
+}
+
+static void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Writes the digits of a finite, positive v into buf; v == digits * 10^K. */
+static int grisu2(double v, char *buf, int *K) {
+    static const uint32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+    };
+    uint64_t u;
+    memcpy(&u, &v, sizeof u);
+    int be = (int)(u >> 52 & 0x7FF);
+    uint64_t frac = u & ((1ULL << 52) - 1);
+    DiyFp w = be ? (DiyFp){ frac | 1ULL << 52, be - 1075 } : (DiyFp){ frac, -1074 };
+
+    /* boundaries m- and m+ halfway to the neighbouring doubles */
+    DiyFp mp = diyfp_normalize((DiyFp){ (w.f << 1) + 1, w.e - 1 });
+    DiyFp mm = w.f == 1ULL << 52 ? (DiyFp){ (w.f << 2) - 1, w.e - 2 }
+                                 : (DiyFp){ (w.f << 1) - 1, w.e - 1 };
+    mm.f <<= mm.e - mp.e;
+    mm.e = mp.e;
+
+    double dk = (-61 - mp.e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) ++k;
+    unsigned idx = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(idx << 3));
+    DiyFp c = { GRISU_POW10_F[idx], GRISU_POW10_E[idx] };
+
+    DiyFp W = diyfp_mul(diyfp_normalize(w), c);
+    DiyFp Wp = diyfp_mul(mp, c), Wm = diyfp_mul(mm, c);
+    Wm.f++;
+    Wp.f--;
+
+    uint64_t delta = Wp.f - Wm.f, wp_w = Wp.f - W.f;
+    DiyFp one = { 1ULL << -Wp.e, Wp.e };
+    uint32_t p1 = (uint32_t)(Wp.f >> -one.e);
+    uint64_t p2 = Wp.f & (one.f - 1);
+    int kappa = 1, len = 0;
+    while (kappa < 10 && p1 >= pow10[kappa]) ++kappa;
+
+    while (kappa > 0) {
+        uint32_t d = p1 / pow10[kappa - 1];
+        p1 %= pow10[kappa - 1];
+        if (d || len) buf[len++] = (char)('0' + d);
+        --kappa;
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *K += kappa;
+            grisu_round(buf, len, delta, rest, (uint64_t)pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || len) buf[len++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            *K += kappa;
+            grisu_round(buf, len, delta, p2, one.f, wp_w * (-kappa < 10 ? pow10[-kappa] : 0));
+            return len;
+        }
+    }
+}
+
+/* Shortest round-trip text for v, like "%.17g" but without the noise
+ * ("9.635", not "9.6350000000000016"); fixed notation for decimal exponents
+ * in [-6, 21), scientific otherwise. Non-finite values print as nan/inf.
+ * buf needs 32 bytes; returns the length (not NUL-terminated). */
+static int fmt_f64(char *buf, double v) {
+    char *p = buf;
+    if (v != v) { memcpy(buf, "nan", 3); return 3; }
+    if (signbit(v)) { *p++ = '-'; v = -v; }
+    if (v == 0.0) { *p++ = '0'; return (int)(p - buf); }
+    if (isinf(v)) { memcpy(p, "inf", 3); return (int)(p - buf) + 3; }
+
+    char d[24];
+    int K, n = grisu2(v, d, &K);
+    int point = n + K;                   /* digits before the decimal point */
+    if (point > 0 && point <= 21) {
+        if (K >= 0) {
+            memcpy(p, d, (size_t)n); p += n;
+            memset(p, '0', (size_t)K); p += K;
+        } else {
+            memcpy(p, d, (size_t)point); p += point;
+            *p++ = '.';
+            memcpy(p, d + point, (size_t)(n - point)); p += n - point;
+        }
+    } else if (point <= 0 && point > -6) {
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', (size_t)-point); p += -point;
+        memcpy(p, d, (size_t)n); p += n;
+    } else {
+        *p++ = d[0];
+        if (n > 1) { *p++ = '.'; memcpy(p, d + 1, (size_t)(n - 1)); p += n - 1; }
+        int e = point - 1;
+        *p++ = 'e';
+        if (e < 0) { *p++ = '-'; e = -e; } else *p++ = '+';
+        if (e >= 100) { *p++ = (char)('0' + e / 100); e %= 100; *p++ = (char)('0' + e / 10); }
+        else if (e >= 10) *p++ = (char)('0' + e / 10);
+        *p++ = (char)('0' + e % 10);
+    }
+    return (int)(p - buf);
+}
+
+static void ob_f64(OutBuf *ob, double v) {
+    char *p = ob_reserve(ob, 32);
+    ob->len += (size_t)fmt_f64(p, v);
+}
+
+/* JSON has no nan/inf; they go out as null. */
+static void ob_json_f64(OutBuf *ob, double v) {
+    if (isfinite(v)) ob_f64(ob, v);
+    else ob_write(ob, "null", 4);
+}
+
+static void ob_json_str(OutBuf *ob, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    ob_write(ob, "\"", 1);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        char *p = ob_reserve(ob, 6);
+        if (c == '"' || c == '\\') { p[0] = '\\'; p[1] = (char)c; ob->len += 2; }
+        else if (c >= 0x20)        { p[0] = (char)c; ob->len += 1; }
+        else {
+            memcpy(p, "\\u00", 4);
+            p[4] = hex[c >> 4];
+            p[5] = hex[c & 15];
+            ob->len += 6;
+        }
+    }
+    ob_write(ob, "\"", 1);
+}
+
+/*======================== I/O ========================*/
+static void print_output(const Inputs *in, const Output *o) {
+    printf("\nAssist Projection for %s\n", in->player_name);
+    printf("----------------------------------------\n");
+    printf("Base (blend)            : %.2f\n", o->base_assists);
+    printf("Multipliers:\n");
+    printf("  Home/Away             : %.4f\n", o->m_homeaway);
+    printf("  Game Total (O/U)      : %.4f\n", o->m_game_total);
+    printf("  Team Total (O/U)      : %.4f\n", o->m_team_total);
+    printf("  Opp AST Allowed       : %.4f\n", o->m_def_ast);
+    printf("  Pace                  : %.4f\n", o->m_pace);
+    printf("  Recent Form           : %.4f\n", o->m_recent);
+    printf("  Minutes Trend         : %.4f\n", o->m_minutes);
+    printf("  Back-to-Back          : %.4f\n", o->m_b2b);
+    printf("  Last-5 Potential AST  : %.4f\n", o->m_potential);
+    printf("Uncapped Multiplier     : %.4f\n", o->uncapped_multiplier);
+    printf("Final Multiplier        : %.4f  (capped to [%.2f, %.2f])\n",
+           o->final_multiplier, MULT_MIN, MULT_MAX);
+    printf("Projected Assists       : %.2f\n", o->projection);
+    printf("P(over / under / push)  : %.3f / %.3f / %.3f\n\n", o->p_over, o->p_under, o->p_push);
+}
+
+/*======================== OUTPUT WRITERS ========================*/
+/* Per-row writers for batch results, all formatting into one OutBuf:
+ *   csv / tsv  header + one row per player, shortest round-trip numbers
+ *   json       one object per line (the --ndjson shape)
+ *   bin        "AOUT" header, then per row: uint32 row index, uint32 zero,
+ *              N_OUTPUT_FIELDS little-endian doubles in Output field order
+ *   explain    the interactive per-player report (opt-in; slow)
+ * The default is csv. */
+typedef enum { OUT_CSV, OUT_TSV, OUT_JSON, OUT_BIN, OUT_EXPLAIN } OutFormat;
+
+#define OUTPUT_FIELDS(X) \
+    X(base_assists) X(m_homeaway) X(m_game_total) X(m_team_total) X(m_def_ast) \
+    X(m_pace) X(m_recent) X(m_minutes) X(m_b2b) X(m_potential)                \
+    X(uncapped_multiplier) X(final_multiplier) X(projection)                  \
+    X(p_over) X(p_under) X(p_push)
+
+#define COUNT_FIELD(f) + 1
+enum { N_OUTPUT_FIELDS = 0 OUTPUT_FIELDS(COUNT_FIELD) };
+#undef COUNT_FIELD
+
+#define AOUT_MAGIC   "AOUT\0\0\0\0"
+#define AOUT_VERSION 2u
+
+static int parse_out_format(const char *s, OutFormat *f) {
+    static const char *const names[] = { "csv", "tsv", "json", "bin", "explain" };
+    for (int i = 0; i < 5; ++i)
+        if (strcmp(s, names[i]) == 0) { *f = (OutFormat)i; return 0; }
+    return -1;
+}
+
+static Output output_row(const OutputSoA *s, size_t i) {
+    Output o;
+#define GATHER(f) o.f = s->f[i];
+    OUTPUT_FIELDS(GATHER)
+#undef GATHER
+    return o;
+}
+
+static void ob_csv_str(OutBuf *ob, const char *s, char sep) {
+    if (sep == '\t') {                   /* TSV: no quoting, so no tabs/newlines */
+        for (; *s; ++s) {
+            char c = (*s == '\t' || *s == '\n' || *s == '\r') ? ' ' : *s;
+            ob_write(ob, &c, 1);
+        }
+        return;
+    }
+    if (!strpbrk(s, ",\"\n\r")) { ob_puts(ob, s); return; }
+    ob_write(ob, "\"", 1);
+    for (; *s; ++s) {
+        if (*s == '"') ob_write(ob, "\"", 1);
+        ob_write(ob, s, 1);
+    }
+    ob_write(ob, "\"", 1);
+}
+
+static void write_header(OutBuf *ob, OutFormat fmt, size_t nrows) {
+    if (fmt == OUT_CSV || fmt == OUT_TSV) {
+        const char *sep = fmt == OUT_CSV ? "," : "\t";
+        ob_puts(ob, "player_name");
+#define HEAD(f) ob_puts(ob, sep); ob_puts(ob, #f);
+        OUTPUT_FIELDS(HEAD)
+#undef HEAD
+        ob_puts(ob, "\n");
+    } else if (fmt == OUT_BIN) {
+        uint32_t hdr[4] = { 0, 0, AOUT_VERSION, N_OUTPUT_FIELDS };
+        uint64_t n = nrows;
+        memcpy(hdr, AOUT_MAGIC, 8);
+        ob_write(ob, (const char *)hdr, sizeof hdr);
+        ob_write(ob, (const char *)&n, sizeof n);
+    }
+}
+
+static void write_row(OutBuf *ob, OutFormat fmt, size_t row,
+                      const char *name, const Output *o) {
+    switch (fmt) {
+    case OUT_CSV:
+    case OUT_TSV: {
+        char sep = fmt == OUT_CSV ? ',' : '\t';
+        ob_csv_str(ob, name, sep);
+        char *p = ob_reserve(ob, N_OUTPUT_FIELDS * 33 + 1), *start = p;
+#define CELL(f) *p++ = sep; p += fmt_f64(p, o->f);
+        OUTPUT_FIELDS(CELL)
+#undef CELL
+        *p++ = '\n';
+        ob->len += (size_t)(p - start);
+        break;
+    }
+    case OUT_JSON:
+        ob_puts(ob, "{\"player_name\":");
+        ob_json_str(ob, name);
+#define JS_FIELD(f) ob_puts(ob, ",\"" #f "\":"); ob_json_f64(ob, o->f);
+        OUTPUT_FIELDS(JS_FIELD)
+#undef JS_FIELD
+        ob_puts(ob, "}\n");
+        break;
+    case OUT_BIN: {
+        uint32_t idx[2] = { (uint32_t)row, 0 };
+        double v[N_OUTPUT_FIELDS];
+        int k = 0;
+#define PACK(f) v[k++] = o->f;
+        OUTPUT_FIELDS(PACK)
+#undef PACK
+        ob_write(ob, (const char *)idx, sizeof idx);
+        ob_write(ob, (const char *)v, sizeof v);
+        break;
+    }
+    case OUT_EXPLAIN: {
+        Inputs in = { .player_name = name };
+        ob_flush(ob);
+        print_output(&in, o);
+        fflush(stdout);
+        break;
+    }
+    }
+}
+
+/* Ladder output is long: one row per (player, line). csv/tsv/json only. */
+static void write_ladder_header(OutBuf *ob, OutFormat fmt) {
+    if (fmt == OUT_CSV)
+        ob_puts(ob, "player_name,line,p_over,p_under,p_push,fair_over,fair_under\n");
+    else if (fmt == OUT_TSV)
+        ob_puts(ob, "player_name\tline\tp_over\tp_under\tp_push\tfair_over\tfair_under\n");
+}
+
+static void write_ladder_row(OutBuf *ob, OutFormat fmt, const char *name, double line,
+                             const LinePrice *p) {
+    if (fmt == OUT_JSON) {
+        ob_puts(ob, "{\"player_name\":");
+        ob_json_str(ob, name);
+        ob_puts(ob, ",\"line\":");       ob_json_f64(ob, line);
+        ob_puts(ob, ",\"p_over\":");     ob_json_f64(ob, p->p_over);
+        ob_puts(ob, ",\"p_under\":");    ob_json_f64(ob, p->p_under);
+        ob_puts(ob, ",\"p_push\":");     ob_json_f64(ob, p->p_push);
+        ob_puts(ob, ",\"fair_over\":");  ob_json_f64(ob, p->fair_over);
+        ob_puts(ob, ",\"fair_under\":"); ob_json_f64(ob, p->fair_under);
+        ob_puts(ob, "}\n");
+        return;
+    }
+    char sep = fmt == OUT_CSV ? ',' : '\t';
+    ob_csv_str(ob, name, sep);
+    char *q = ob_reserve(ob, 6 * 33 + 1), *start = q;
+    const double v[6] = { line, p->p_over, p->p_under, p->p_push, p->fair_over, p->fair_under };
+    for (int k = 0; k < 6; ++k) {
+        *q++ = sep;
+        q += fmt_f64(q, v[k]);
+    }
+    *q++ = '\n';
+    ob->len += (size_t)(q - start);
+}
+
+/* Simulation summaries: one row per player. csv/tsv/json only. */
+#define SIM_FIELDS(X) X(mean) X(sd) X(p_over) X(p_under) X(p_push) X(q10) X(q50) X(q90)
+
+static void write_sim_header(OutBuf *ob, OutFormat fmt) {
+    if (fmt == OUT_JSON) return;
+    const char *sep = fmt == OUT_CSV ? "," : "\t";
+    ob_puts(ob, "player_name");
+#define HEAD(f) ob_puts(ob, sep); ob_puts(ob, #f);
+    SIM_FIELDS(HEAD)
+#undef HEAD
+    ob_puts(ob, "\n");
+}
+
+static void write_sim_row(OutBuf *ob, OutFormat fmt, const char *name, const SimSummary *m) {
+    if (fmt == OUT_JSON) {
+        ob_puts(ob, "{\"player_name\":");
+        ob_json_str(ob, name);
+#define JS_FIELD(f) ob_puts(ob, ",\"" #f "\":"); ob_json_f64(ob, m->f);
+        SIM_FIELDS(JS_FIELD)
+#undef JS_FIELD
+        ob_puts(ob, "}\n");
+        return;
+    }
+    char sep = fmt == OUT_CSV ? ',' : '\t';
+    ob_csv_str(ob, name, sep);
+    char *p = ob_reserve(ob, 8 * 33 + 1), *start = p;
+#define CELL(f) *p++ = sep; p += fmt_f64(p, m->f);
+    SIM_FIELDS(CELL)
+#undef CELL
+    *p++ = '\n';
+    ob->len += (size_t)(p - start);
+}
+
+/* Raw draws: "ASIM" header (magic, uint32 version, uint32 zero, uint64
+ * players, uint64 sims), then players * sims uint8 outcomes, player-major. */
+#define ASIM_MAGIC   "ASIM\0\0\0\0"
+#define ASIM_VERSION 1u
+
+/* write() until all n bytes are out; 0 or -1. */
+static int write_all(int fd, const void *p, size_t n) {
+    for (size_t off = 0; off < n; ) {
+        ssize_t w = write(fd, (const char *)p + off, n - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        off += (size_t)w;
+    }
+    return 0;
+}
+
+static int write_sim_draws(const char *path, const uint8_t *draws, size_t n, size_t nsims) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct { char magic[8]; uint32_t version, reserved; uint64_t nplayers, nsims; } h = {
+        ASIM_MAGIC, ASIM_VERSION, 0, n, nsims };
+    int ok = write_all(fd, &h, sizeof h) == 0 && write_all(fd, draws, n * nsims) == 0;
+    if (close(fd) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok ? 0 : -1;
+}
+
+/*======================== SWEEPS ========================*/
+/* Evaluates the loss over a grid (or a random sample) of weight settings
+ * that vary only a few parameters. The factors that do not move are cached
+ * as a single per-row product, so a sweep point costs one multiply per row
+ * for each swept factor, plus the cap and the loss. The cache also keeps
+ * the base when neither base weight is swept. Products are taken in a
+ * different order than project(), so losses can differ from a full
+ * recompute in the last few ulps. */
+#define SWEEP_CHUNK 8192
+
+typedef struct {
+    int param;                   /* index into the Weights vector */
+    double lo, hi;
+    int steps;                   /* grid points, >= 1 */
+} SweepAxis;
+
+typedef struct {
+    size_t n;
+    int naxes;
+    const SweepAxis *axes;
+    int swept[N_PARAMS];         /* 1 if the parameter varies */
+    int sweep_base;              /* either base weight varies */
+    double *rest;                /* product of the unswept factors */
+    double *base;                /* base assists, when not sweep_base */
+    double *slope[N_FACTORS];    /* df_k/dw_k, for swept factors only */
+    const double *line, *season;
+    void *block;
+} SweepCache;
+
+/* "NAME=LO:HI[:STEPS]" with NAME from PARAM_NAMES; STEPS defaults to 11. */
+static int parse_sweep_axis(const char *s, SweepAxis *a) {
+    const char *eq = strchr(s, '=');
+    if (!eq) return -1;
+    a->param = -1;
+    for (int j = 0; j < N_PARAMS; ++j)
+        if (strlen(PARAM_NAMES[j]) == (size_t)(eq - s) && strncmp(s, PARAM_NAMES[j], (size_t)(eq - s)) == 0)
+            a->param = j;
+    if (a->param < 0) return -1;
+    char *end;
+    a->lo = strtod(eq + 1, &end);
+    if (*end != ':') return -1;
+    a->hi = strtod(end + 1, &end);
+    a->steps = 11;
+    if (*end == ':') a->steps = (int)strtol(end + 1, &end, 10);
+    return *end == 0 && a->steps >= 1 ? 0 : -1;
+}
+
+static void sweep_cache_free(SweepCache *c) {
+    free(c->block);
+    memset(c, 0, sizeof *c);
+}
+
+/* Caches everything the axes do not touch, evaluated at w. */
+static int sweep_cache_build(SweepCache *c, const Weights *w, const InputsSoA *in,
+                             const SweepAxis *axes, int naxes) {
+    memset(c, 0, sizeof *c);
+    c->n = in->n;
+    c->naxes = naxes;
+    c->axes = axes;
+    for (int a = 0; a < naxes; ++a) c->swept[axes[a].param] = 1;
+    c->sweep_base = c->swept[0] || c->swept[1];
+
+    void **cols[2 + N_FACTORS];
+    size_t elem[2 + N_FACTORS];
+    int ncols = 0;
+    cols[ncols++] = (void **)&c->rest;
+    if (!c->sweep_base) cols[ncols++] = (void **)&c->base;
+    for (int k = 0; k < N_FACTORS; ++k)
+        if (c->swept[2 + k]) cols[ncols++] = (void **)&c->slope[k];
+    for (int j = 0; j < ncols; ++j) elem[j] = sizeof(double);
+    c->block = soa_carve(in->n, elem, cols, ncols);
+    if (!c->block) return -1;
+    c->line = in->line_ast;
+    c->season = in->season_avg_ast;
+
+    for (size_t i = 0; i < in->n; ++i) {
+        double f[N_FACTORS], d[N_FACTORS], rest = 1.0;
+        row_factors(w, in, i, f, d);
+        for (int k = 0; k < N_FACTORS; ++k) {
+            if (c->swept[2 + k]) c->slope[k][i] = d[k];
+            else rest *= f[k];
+        }
+        c->rest[i] = rest;
+        if (!c->sweep_base) c->base[i] = w->base_line * in->line_ast[i] + w->base_season * in->season_avg_ast[i];
+    }
+    return 0;
+}
+
+typedef struct {
+    const SweepCache *cache;
+    const double *actual;
+    const Loss *loss;
+    Weights w;
+    double *parts;               /* loss sum per task */
+} SweepJob;
+
+static void sweep_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    SweepJob *job = ctx;
+    const SweepCache *c = job->cache;
+    const Weights *w = &job->w;
+    const double *wv = (const double *)w + 2;
+    size_t lo = task * SWEEP_CHUNK;
+    size_t hi = lo + SWEEP_CHUNK < c->n ? lo + SWEEP_CHUNK : c->n;
+
+    int ks[N_FACTORS], nk = 0;
+    for (int k = 0; k < N_FACTORS; ++k)
+        if (c->swept[2 + k]) ks[nk++] = k;
+
+    double sum = 0.0, dldp;
+    for (size_t i = lo; i < hi; ++i) {
+        double m = c->rest[i];
+        for (int t = 0; t < nk; ++t) m *= factor_value(ks[t], c->slope[ks[t]][i], wv[ks[t]]);
+        double base = c->sweep_base ? w->base_line * c->line[i] + w->base_season * c->season[i] : c->base[i];
+        sum += loss_point(job->loss, base * clamp(m, w->mult_min, w->mult_max), job->actual[i], &dldp);
+    }
+    job->parts[task] = sum;
+}
+
+static double sweep_eval(ThreadPool *pool, SweepJob *job, const Weights *w) {
+    size_t ntasks = (job->cache->n + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    job->w = *w;
+    pool_run(pool, ntasks, sweep_task, job);
+    double sum = 0.0;
+    for (size_t t = 0; t < ntasks; ++t) sum += job->parts[t];
+    return loss_finish(job->loss, sum, NULL, job->cache->n);
+}
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+typedef struct {
+    Loss loss;
+    size_t random;               /* sample this many points instead of the grid */
+    uint64_t seed;
+} SweepOptions;
+
+/* Writes one CSV line per point (swept values, loss) and leaves the best
+ * point in *best. Returns its loss, or -1 on allocation failure. */
+static double sweep_run(ThreadPool *pool, const SweepCache *c, const double *actual,
+                        const SweepOptions *opt, const Weights *start, Weights *best, OutBuf *ob) {
+    size_t ntasks = (c->n + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    SweepJob job = { c, actual, &opt->loss, *start, calloc(ntasks ? ntasks : 1, sizeof(double)) };
+    if (!job.parts) return -1.0;
+
+    size_t npoints = opt->random;
+    if (!npoints) {
+        npoints = 1;
+        for (int a = 0; a < c->naxes; ++a) npoints *= (size_t)c->axes[a].steps;
+    }
+    for (int a = 0; a < c->naxes; ++a) {
+        ob_puts(ob, PARAM_NAMES[c->axes[a].param]);
+        ob_write(ob, ",", 1);
+    }
+    ob_puts(ob, "loss\n");
+
+    uint64_t rng = opt->seed;
+    double best_loss = INFINITY;
+    *best = *start;
+    for (size_t pt = 0; pt < npoints; ++pt) {
+        Weights w = *start;
+        size_t idx = pt;
+        for (int a = c->naxes - 1; a >= 0; --a) {
+            const SweepAxis *ax = &c->axes[a];
+            double t;
+            if (opt->random) {
+                t = (double)(splitmix64(&rng) >> 11) * 0x1.0p-53;
+            } else {
+                t = ax->steps > 1 ? (double)(idx % (size_t)ax->steps) / (ax->steps - 1) : 0.0;
+                idx /= (size_t)ax->steps;
+            }
+            weights_vec(&w)[ax->param] = ax->lo + (ax->hi - ax->lo) * t;
+        }
+        double l = sweep_eval(pool, &job, &w);
+        if (l < best_loss) { best_loss = l; *best = w; }
+        for (int a = 0; a < c->naxes; ++a) {
+            ob_f64(ob, weights_vec(&w)[c->axes[a].param]);
+            ob_write(ob, ",", 1);
+        }
+        ob_f64(ob, l);
+        ob_write(ob, "\n", 1);
+    }
+    free(job.parts);
+    return best_loss;
+}
+
+/*======================== BACKTEST ========================*/
+/* Scores the projection against recorded outcomes: error, bias by
+ * projection bucket, and the record/ROI of betting the side the model
+ * favours at the posted odds. Rows are projected and scored in BT_BLOCK
+ * blocks, so memory does not grow with the archive. Within a block each
+ * BT_CHUNK-row task projects its rows with the active batch kernel and
+ * accumulates one BtStats per group into its own partial. The partials are
+ * merged in task order and the blocks in file order, so totals are
+ * identical for any thread count. Groups are seasons, numbered in order of
+ * first appearance. */
+#define BT_BLOCK 65536
+#define BT_CHUNK 4096
+#define BT_MAX_GROUPS 64
+#define BT_BUCKETS 8
+#define BT_BUCKET_WIDTH 2.0      /* projection buckets [0,2) [2,4) ... [14,inf) */
+
+typedef struct {
+    size_t n;
+    double abs_err, err, sq_err; /* err = projection - actual */
+    size_t wins, losses, pushes;
+    double profit;               /* units won, one unit staked per bet */
+    size_t bucket_n[BT_BUCKETS];
+    double bucket_err[BT_BUCKETS];
+} BtStats;
+
+typedef struct {
+    double edge;                 /* bet only when |projection - line| > edge */
+    double odds;                 /* American odds when the file has none */
+} BacktestOptions;
+
+/* One block of rows: inputs, projections and outcome columns. */
+typedef struct {
+    InputsSoA in;
+    OutputSoA out;
+    double *actual, *over_odds, *under_odds;
+    uint16_t *group;
+    void *block;
+    size_t n;
+} BtBlock;
+
+static int bt_block_alloc(BtBlock *b) {
+    memset(b, 0, sizeof *b);
+    void **cols[] = { (void **)&b->actual, (void **)&b->over_odds, (void **)&b->under_odds,
+                      (void **)&b->group };
+    size_t elem[] = { sizeof(double), sizeof(double), sizeof(double), sizeof(uint16_t) };
+    b->block = soa_carve(BT_BLOCK, elem, cols, 4);
+    if (!b->block || inputs_soa_alloc(&b->in, BT_BLOCK) != 0 || output_soa_alloc(&b->out, BT_BLOCK) != 0)
+        return -1;
+    return 0;
+}
+
+static void bt_block_free(BtBlock *b) {
+    inputs_soa_free(&b->in);
+    output_soa_free(&b->out);
+    free(b->block);
+    memset(b, 0, sizeof *b);
+}
+
+/* Profit on a one-unit winning bet at American odds. */
+static double bt_payout(double odds) {
+    return odds > 0.0 ? odds / 100.0 : 100.0 / -odds;
+}
+
+static void bt_score(BtStats *s, double proj, double line, double actual,
+                     double over_odds, double under_odds, double edge) {
+    double e = proj - actual;
+    s->n++;
+    s->abs_err += fabs(e);
+    s->err += e;
+    s->sq_err += e * e;
+    int b = proj <= 0.0 ? 0 : (int)(proj / BT_BUCKET_WIDTH);
+    if (b >= BT_BUCKETS) b = BT_BUCKETS - 1;
+    s->bucket_n[b]++;
+    s->bucket_err[b] += e;
+
+    int side = proj - line > edge ? 1 : (line - proj > edge ? -1 : 0);
+    if (!side) return;
+    if (actual == line) {
+        s->pushes++;
+    } else if ((actual > line) == (side > 0)) {
+        s->wins++;
+        s->profit += bt_payout(side > 0 ? over_odds : under_odds);
+    } else {
+        s->losses++;
+        s->profit -= 1.0;
+    }
+}
+
+static void bt_merge(BtStats *dst, const BtStats *src) {
+    dst->n += src->n;
+    dst->abs_err += src->abs_err;
+    dst->err += src->err;
+    dst->sq_err += src->sq_err;
+    dst->wins += src->wins;
+    dst->losses += src->losses;
+    dst->pushes += src->pushes;
+    dst->profit += src->profit;
+    for (int b = 0; b < BT_BUCKETS; ++b) {
+        dst->bucket_n[b] += src->bucket_n[b];
+        dst->bucket_err[b] += src->bucket_err[b];
+    }
+}
+
+typedef struct {
+    BtBlock *blk;
+    const BacktestOptions *opt;
+    int ngroups;
+    BtStats *parts;              /* BT_MAX_GROUPS per task */
+} BtJob;
+
+static void bt_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    BtJob *job = ctx;
+    BtBlock *b = job->blk;
+    size_t lo = task * BT_CHUNK, hi = lo + BT_CHUNK < b->n ? lo + BT_CHUNK : b->n;
+    BtStats *part = &job->parts[task * BT_MAX_GROUPS];
+    memset(part, 0, (size_t)job->ngroups * sizeof *part);
+
+    active_kernel->fn(&b->in, &b->out, lo, hi);
+    line_probs_range(&b->in, &b->out, lo, hi);
+    for (size_t i = lo; i < hi; ++i)
+        bt_score(&part[b->group[i]], b->out.projection[i], b->in.line_ast[i], b->actual[i],
+                 b->over_odds[i], b->under_odds[i], job->opt->edge);
+}
+
+/* Projects and scores one filled block, folding it into totals[group]. */
+static void bt_run_block(ThreadPool *pool, BtJob *job, BtStats *totals) {
+    size_t ntasks = (job->blk->n + BT_CHUNK - 1) / BT_CHUNK;
+    pool_run(pool, ntasks, bt_task, job);
+    for (size_t t = 0; t < ntasks; ++t)
+        for (int g = 0; g < job->ngroups; ++g) bt_merge(&totals[g], &job->parts[t * BT_MAX_GROUPS + g]);
+}
+
+static void bt_print_row(const char *label, const BtStats *s) {
+    double n = s->n ? (double)s->n : 1.0;
+    size_t decided = s->wins + s->losses, staked = decided + s->pushes;
+    printf("%-8s %9zu %7.3f %7.3f %+7.3f %8zu %6.1f%% %6zu %+6.1f%%\n", label, s->n,
+           s->abs_err / n, sqrt(s->sq_err / n), s->err / n, staked,
+           decided ? 100.0 * (double)s->wins / (double)decided : 0.0, s->pushes,
+           staked ? 100.0 * s->profit / (double)staked : 0.0);
+}
+
+static void bt_report(const BtStats *totals, const int *seasons, int ngroups) {
+    BtStats all = {0};
+    printf("%-8s %9s %7s %7s %7s %8s %7s %6s %7s\n",
+           "season", "rows", "MAE", "RMSE", "bias", "bets", "hit", "push", "ROI");
+    for (int g = 0; g < ngroups; ++g) {
+        char label[16];
+        snprintf(label, sizeof label, "%d", seasons[g]);
+        bt_print_row(label, &totals[g]);
+        bt_merge(&all, &totals[g]);
+    }
+    bt_print_row("all", &all);
+
+    printf("\n%-10s %9s %7s\n", "projected", "rows", "bias");
+    for (int b = 0; b < BT_BUCKETS; ++b) {
+        char label[40];
+        if (b + 1 < BT_BUCKETS)
+            snprintf(label, sizeof label, "[%g,%g)", b * BT_BUCKET_WIDTH, (b + 1) * BT_BUCKET_WIDTH);
+        else
+            snprintf(label, sizeof label, "[%g,inf)", b * BT_BUCKET_WIDTH);
+        printf("%-10s %9zu %+7.3f\n", label, all.bucket_n[b],
+               all.bucket_n[b] ? all.bucket_err[b] / (double)all.bucket_n[b] : 0.0);
+    }
+}
+
+/*======================== LINE HISTORY STORE ========================*/
+/* Append-only, columnar store of every assist-line and price change, keyed
+ * by (player, book). Each series is cut into blocks of up to LINE_BLOCK
+ * points, in time order:
+ *
+ *   AlinesHeader         16 bytes
+ *   records              appended in order, each starting with a uint32 kind:
+ *     ALINES_NAME        a player or book name; ids are dense per table, in
+ *                        order of appearance
+ *     ALINES_BLOCK       LineBlockHeader, then `nbytes` of bit-packed
+ *                        points 1..count-1 (point 0 is in the header)
+ *
+ * Timestamps are minutes since 1970 (converted from yyyymmddHHMM) and are
+ * coded as a delta-of-delta: '0' means the same gap as before, otherwise a
+ * 2-4 bit prefix selects a 7, 12, 20 or 40 bit zigzag value. The line is
+ * quantized to half points and the American odds to whole units. Both are
+ * coded as deltas from the previous point: '0' means unchanged, '10' adds
+ * a 6-bit zigzag value, '11' an 18-bit one. Books usually hold the vig, so
+ * when the over price moves by d the under is coded as its move plus d,
+ * which is normally 0. A typical change costs about 3.5 bytes, against
+ * about 40 as CSV text.
+ *
+ * Every block header carries the block's time range, its line min/max,
+ * and its first and last values. Opening a store reads only the headers
+ * and builds a sorted index. An as-of lookup binary-searches that index.
+ * It decodes at most one block, and decodes none when the asked-for time
+ * is at or after the block's last point. A torn tail left by a crash
+ * during an append is dropped when the store is opened. */
+#define LINE_BLOCK 256
+#define LINE_CACHE 64            /* decoded blocks kept, direct-mapped */
+
+/* Field widths, and the input bounds that make them sufficient. A move
+ * between two values is at most 2 * LINE_VALUE_MAX; the under residual
+ * adds two moves; zigzag doubles the magnitude. Timestamps span at most
+ * LINE_YEAR_MAX + 1 years of minutes, and a change of gap is at most
+ * twice that span before zigzag doubles it again. */
+#define LINE_VALUE_MAX  32766    /* |line| in half points, |odds| */
+#define LINE_YEAR_MAX   9999
+#define LINE_DELTA_BITS 18
+#define LINE_DOD_BITS   40
+_Static_assert(2 * 2 * (2 * LINE_VALUE_MAX) < (1 << LINE_DELTA_BITS),
+               "under residual must fit its delta field");
+_Static_assert(2 * 2 * ((int64_t)(LINE_YEAR_MAX + 1) * 366 * 1440) < ((int64_t)1 << LINE_DOD_BITS),
+               "any gap change must fit the widest delta-of-delta field");
+
+#define ALINES_MAGIC   "ALINES\0\0"
+#define ALINES_VERSION 1u
+
+enum { ALINES_NAME = 1, ALINES_BLOCK = 2 };
+enum { LINE_NAMES_PLAYER = 0, LINE_NAMES_BOOK = 1 };
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+} AlinesHeader;
+
+typedef struct {
+    uint32_t kind;               /* ALINES_NAME */
+    uint32_t table;              /* LINE_NAMES_PLAYER or LINE_NAMES_BOOK */
+    uint32_t id;
+    uint32_t len;                /* name bytes that follow, no NUL */
+} LineNameRecord;
+
+typedef struct {
+    uint32_t kind;               /* ALINES_BLOCK */
+    uint32_t player, book;
+    uint32_t count;
+    uint32_t nbytes;             /* payload bytes after this header */
+    int16_t line_min, line_max;  /* half points */
+    int64_t ts_min, ts_max;      /* minutes since 1970 */
+    int16_t line0, over0, under0;
+    int16_t line_last, over_last, under_last;
+    uint32_t reserved;
+} LineBlockHeader;
+
+typedef struct {
+    int64_t ts;                  /* minutes since 1970 */
+    int16_t line;                /* half points */
+    int16_t over, under;         /* American odds */
+} LinePoint;
+
+/* Index entry: the block header fields a lookup needs, plus its offset. */
+typedef struct {
+    uint32_t player, book;
+    int64_t ts_min, ts_max;
+    int16_t line_min, line_max;
+    LinePoint last;
+    uint64_t offset;
+} LineBlockRef;
+
+/* A series being appended to: points not yet written, and the newest ts
+ * already in the store, which later points may not precede. */
+typedef struct {
+    uint32_t player, book;
+    int64_t last_ts;
+    uint32_t n;
+    LinePoint *pending;
+} LineSeries;
+
+typedef struct {
+    StrTab players, books;
+    LineBlockRef *blocks;        /* sorted by (player, book, ts_min) */
+    size_t nblocks, cap;
+    uint64_t npoints, payload_bytes, valid_end;
+    const unsigned char *map;
+    size_t size;
+    /* appending */
+    FILE *out;
+    LineSeries *series;
+    size_t nseries, series_cap;
+    uint32_t *slots;             /* (player, book) -> series index + 1 */
+    size_t nslots;
+    /* decoded-block cache for lookups */
+    size_t cache_block[LINE_CACHE];   /* block index + 1, 0 = empty */
+    LinePoint *cache;                 /* LINE_CACHE * LINE_BLOCK points */
+} LineStore;
+
+/* yyyymmddHHMM <-> minutes since 1970-01-01 00:00 (proleptic Gregorian). */
+static int64_t days_from_civil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+static int ts_to_minutes(int64_t ts, int64_t *out) {
+    int mi = (int)(ts % 100), h = (int)(ts / 100 % 100);
+    int d = (int)(ts / 10000 % 100), m = (int)(ts / 1000000 % 100);
+    int64_t y = ts / 100000000;
+    if (ts < 0 || y > LINE_YEAR_MAX || mi > 59 || h > 23 || d < 1 || d > 31 || m < 1 || m > 12)
+        return -1;
+    *out = (days_from_civil(y, m, d) * 24 + h) * 60 + mi;
+    return 0;
+}
+
+static int64_t minutes_to_ts(int64_t t) {
+    int64_t z = (t >= 0 ? t : t - 1439) / 1440, mins = t - z * 1440;
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t d = doy - (153 * mp + 2) / 5 + 1, m = mp < 10 ? mp + 3 : mp - 9;
+    int64_t y = yoe + era * 400 + (m <= 2);
+    return ((y * 100 + m) * 100 + d) * 10000 + mins / 60 * 100 + mins % 60;
+}
+
+/*------------------------ bit packing ------------------------*/
+typedef struct {
+    unsigned char *buf;
+    size_t nbits;
+} BitWriter;
+
+typedef struct {
+    const unsigned char *buf;
+    size_t pos, nbits;
+} BitReader;
+
+/* MSB first; the buffer must be zeroed. */
+static void bits_put(BitWriter *w, uint64_t v, int n) {
+    for (int i = n - 1; i >= 0; --i, ++w->nbits)
+        if ((v >> i) & 1) w->buf[w->nbits >> 3] |= (unsigned char)(0x80u >> (w->nbits & 7));
+}
+
+static uint64_t bits_get(BitReader *r, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; ++i, ++r->pos) {
+        unsigned bit = r->pos < r->nbits ? (r->buf[r->pos >> 3] >> (7 - (r->pos & 7))) & 1u : 0u;
+        v = v << 1 | bit;
+    }
+    return v;
+}
+
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag(uint64_t z) { return (int64_t)(z >> 1) ^ -(int64_t)(z & 1); }
+
+static void put_dod(BitWriter *w, int64_t dod) {
+    uint64_t z = zigzag(dod);
+    if (z == 0)               bits_put(w, 0, 1);
+    else if (z < 1u << 7)     { bits_put(w, 2, 2);  bits_put(w, z, 7); }
+    else if (z < 1u << 12)    { bits_put(w, 6, 3);  bits_put(w, z, 12); }
+    else if (z < 1u << 20)    { bits_put(w, 14, 4); bits_put(w, z, 20); }
+    else                      { bits_put(w, 15, 4); bits_put(w, z, LINE_DOD_BITS); }
+}
+
+static int64_t get_dod(BitReader *r) {
+    if (!bits_get(r, 1)) return 0;
+    if (!bits_get(r, 1)) return unzigzag(bits_get(r, 7));
+    if (!bits_get(r, 1)) return unzigzag(bits_get(r, 12));
+    if (!bits_get(r, 1)) return unzigzag(bits_get(r, 20));
+    return unzigzag(bits_get(r, LINE_DOD_BITS));
+}
+
+static void put_delta(BitWriter *w, int64_t d) {
+    uint64_t z = zigzag(d);
+    if (z == 0)          bits_put(w, 0, 1);
+    else if (z < 64)     { bits_put(w, 2, 2); bits_put(w, z, 6); }
+    else                 { bits_put(w, 3, 2); bits_put(w, z, LINE_DELTA_BITS); }
+}
+
+static int64_t get_delta(BitReader *r) {
+    if (!bits_get(r, 1)) return 0;
+    return unzigzag(bits_get(r, bits_get(r, 1) ? LINE_DELTA_BITS : 6));
+}
+
+/* Worst case per point: the widest timestamp code and three wide deltas. */
+#define LINE_POINT_MAXBITS (4 + LINE_DOD_BITS + 3 * (2 + LINE_DELTA_BITS))
+
+static size_t line_block_encode(const LinePoint *p, uint32_t n, LineBlockHeader *h, unsigned char *buf) {
+    BitWriter w = { buf, 0 };
+    memset(buf, 0, ((size_t)n * LINE_POINT_MAXBITS + 7) / 8);
+    h->line_min = h->line_max = p[0].line;
+    int64_t gap = 0;
+    for (uint32_t i = 1; i < n; ++i) {
+        int64_t g = p[i].ts - p[i - 1].ts;
+        put_dod(&w, g - gap);
+        gap = g;
+        put_delta(&w, p[i].line - p[i - 1].line);
+        put_delta(&w, p[i].over - p[i - 1].over);
+        put_delta(&w, (p[i].under - p[i - 1].under) + (p[i].over - p[i - 1].over));
+        if (p[i].line < h->line_min) h->line_min = p[i].line;
+        if (p[i].line > h->line_max) h->line_max = p[i].line;
+    }
+    h->count = n;
+    h->ts_min = p[0].ts;
+    h->ts_max = p[n - 1].ts;
+    h->line0 = p[0].line;
+    h->over0 = p[0].over;
+    h->under0 = p[0].under;
+    h->line_last = p[n - 1].line;
+    h->over_last = p[n - 1].over;
+    h->under_last = p[n - 1].under;
+    h->nbytes = (uint32_t)((w.nbits + 7) / 8);
+    return h->nbytes;
+}
+
+/* Returns 0, or -1 if the points run past the payload (a corrupt block). */
+static int line_block_decode(const LineBlockHeader *h, const unsigned char *payload, LinePoint *p) {
+    BitReader r = { payload, 0, (size_t)h->nbytes * 8 };
+    p[0] = (LinePoint){ h->ts_min, h->line0, h->over0, h->under0 };
+    int64_t gap = 0;
+    for (uint32_t i = 1; i < h->count; ++i) {
+        gap += get_dod(&r);
+        p[i].ts = p[i - 1].ts + gap;
+        p[i].line  = (int16_t)(p[i - 1].line + get_delta(&r));
+        int64_t d_over = get_delta(&r);
+        p[i].over  = (int16_t)(p[i - 1].over + d_over);
+        p[i].under = (int16_t)(p[i - 1].under + get_delta(&r) - d_over);
+    }
+    return r.pos <= r.nbits ? 0 : -1;
+}
+
+/*------------------------ open / index ------------------------*/
+static int line_ref_cmp(const void *a, const void *b) {
+    const LineBlockRef *x = a, *y = b;
+    if (x->player != y->player) return x->player < y->player ? -1 : 1;
+    if (x->book != y->book) return x->book < y->book ? -1 : 1;
+    if (x->ts_min != y->ts_min) return x->ts_min < y->ts_min ? -1 : 1;
+    return x->offset < y->offset ? -1 : (x->offset > y->offset);
+}
+
+static void line_store_close(LineStore *s) {
+    if (s->out) fclose(s->out);
+    if (s->map) munmap((void *)s->map, s->size);
+    for (size_t i = 0; i < s->nseries; ++i) free(s->series[i].pending);
+    free(s->series);
+    free(s->slots);
+    free(s->blocks);
+    free(s->cache);
+    strtab_free(&s->players);
+    strtab_free(&s->books);
+    memset(s, 0, sizeof *s);
+}
+
+/* Maps `path` and indexes its block headers; payloads are not read. A
+ * missing file is an empty store. Returns 0, or -1 with a message. */
+static int line_store_open(LineStore *s, const char *path) {
+    memset(s, 0, sizeof *s);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0;
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) { perror(path); close(fd); return -1; }
+    if (st.st_size == 0) { close(fd); return 0; }     /* empty: same as missing */
+    s->size = (size_t)st.st_size;
+    void *map = mmap(NULL, s->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { perror(path); s->size = 0; return -1; }
+#ifdef MADV_RANDOM
+    madvise(map, s->size, MADV_RANDOM);
+#endif
+    s->map = map;
+
+    AlinesHeader fh;
+    if (s->size < sizeof fh || (memcpy(&fh, s->map, sizeof fh), memcmp(fh.magic, ALINES_MAGIC, 8) != 0) ||
+        fh.version != ALINES_VERSION) {
+        fprintf(stderr, "%s: not a version %u .alines store\n", path, ALINES_VERSION);
+        line_store_close(s);
+        return -1;
+    }
+    uint64_t pos = sizeof fh;
+    for (;;) {
+        uint32_t kind;
+        if (s->size - pos < sizeof kind) break;
+        memcpy(&kind, s->map + pos, sizeof kind);
+        if (kind == ALINES_NAME) {
+            LineNameRecord nr;
+            if (s->size - pos < sizeof nr) break;
+            memcpy(&nr, s->map + pos, sizeof nr);
+            if (s->size - pos - sizeof nr < nr.len) break;
+            StrTab *t = nr.table == LINE_NAMES_BOOK ? &s->books
+                      : nr.table == LINE_NAMES_PLAYER ? &s->players : NULL;
+            if (!t || strtab_intern(t, (const char *)s->map + pos + sizeof nr, nr.len) != nr.id) {
+                fprintf(stderr, "%s: corrupt name record at offset %llu\n", path, (unsigned long long)pos);
+                line_store_close(s);
+                return -1;
+            }
+            pos += sizeof nr + nr.len;
+        } else if (kind == ALINES_BLOCK) {
+            LineBlockHeader h;
+            if (s->size - pos < sizeof h) break;
+            memcpy(&h, s->map + pos, sizeof h);
+            if (s->size - pos - sizeof h < h.nbytes) break;
+            if (h.count == 0 || h.count > LINE_BLOCK || h.player >= s->players.count ||
+                h.book >= s->books.count) {
+                fprintf(stderr, "%s: corrupt block at offset %llu\n", path, (unsigned long long)pos);
+                line_store_close(s);
+                return -1;
+            }
+            if (s->nblocks == s->cap) {
+                size_t cap = s->cap ? s->cap * 2 : 1024;
+                LineBlockRef *b = realloc(s->blocks, cap * sizeof *b);
+                if (!b) { fprintf(stderr, "out of memory indexing %s\n", path); line_store_close(s); return -1; }
+                s->blocks = b;
+                s->cap = cap;
+            }
+            s->blocks[s->nblocks++] = (LineBlockRef){
+                h.player, h.book, h.ts_min, h.ts_max, h.line_min, h.line_max,
+                { h.ts_max, h.line_last, h.over_last, h.under_last }, pos };
+            s->npoints += h.count;
+            s->payload_bytes += h.nbytes;
+            pos += sizeof h + h.nbytes;
+        } else {
+            break;
+        }
+    }
+    if (pos < s->size)
+        fprintf(stderr, "%s: ignoring %llu bytes of torn or unknown tail\n", path,
+                (unsigned long long)(s->size - pos));
+    s->valid_end = pos;
+    if (s->nblocks) qsort(s->blocks, s->nblocks, sizeof *s->blocks, line_ref_cmp);
+    return 0;
+}
+
+/*------------------------ appending ------------------------*/
+static uint64_t series_key_hash(uint32_t player, uint32_t book) {
+    return mix64(((uint64_t)player << 32) | book);
+}
+
+/* Series for (player, book), created on first use; NULL on OOM. */
+static LineSeries *line_series_get(LineStore *s, uint32_t player, uint32_t book) {
+    if (2 * (s->nseries + 1) > s->nslots) {
+        size_t nslots = s->nslots ? s->nslots * 2 : 1024;
+        uint32_t *slots = calloc(nslots, sizeof *slots);
+        if (!slots) return NULL;
+        for (size_t i = 0; i < s->nseries; ++i) {
+            size_t k = series_key_hash(s->series[i].player, s->series[i].book) & (nslots - 1);
+            while (slots[k]) k = (k + 1) & (nslots - 1);
+            slots[k] = (uint32_t)i + 1;
+        }
+        free(s->slots);
+        s->slots = slots;
+        s->nslots = nslots;
+    }
+    size_t k = series_key_hash(player, book) & (s->nslots - 1);
+    for (; s->slots[k]; k = (k + 1) & (s->nslots - 1)) {
+        LineSeries *ls = &s->series[s->slots[k] - 1];
+        if (ls->player == player && ls->book == book) return ls;
+    }
+    if (s->nseries == s->series_cap) {
+        size_t cap = s->series_cap ? s->series_cap * 2 : 256;
+        LineSeries *n = realloc(s->series, cap * sizeof *n);
+        if (!n) return NULL;
+        s->series = n;
+        s->series_cap = cap;
+    }
+    LineSeries *ls = &s->series[s->nseries];
+    *ls = (LineSeries){ player, book, INT64_MIN, 0, malloc(LINE_BLOCK * sizeof(LinePoint)) };
+    if (!ls->pending) return NULL;
+    s->slots[k] = (uint32_t)s->nseries++ + 1;
+    return ls;
+}
+
+static int line_write_name(LineStore *s, uint32_t table, uint32_t id, const char *name) {
+    LineNameRecord nr = { ALINES_NAME, table, id, (uint32_t)strlen(name) };
+    return fwrite(&nr, sizeof nr, 1, s->out) == 1 && fwrite(name, 1, nr.len, s->out) == nr.len ? 0 : -1;
+}
+
+/* Decodes a freshly encoded block and compares it with its source, so a
+ * coding bug fails the write instead of corrupting the store. */
+static int line_block_verify(const LineBlockHeader *h, const unsigned char *buf, const LinePoint *p) {
+    LinePoint dec[LINE_BLOCK];
+    if (line_block_decode(h, buf, dec) != 0) return -1;
+    for (uint32_t i = 0; i < h->count; ++i)
+        if (dec[i].ts != p[i].ts || dec[i].line != p[i].line || dec[i].over != p[i].over ||
+            dec[i].under != p[i].under) return -1;
+    return 0;
+}
+
+static int line_series_flush(LineStore *s, LineSeries *ls) {
+    if (!ls->n) return 0;
+    unsigned char buf[(LINE_BLOCK * LINE_POINT_MAXBITS + 7) / 8];
+    LineBlockHeader h = { .kind = ALINES_BLOCK, .player = ls->player, .book = ls->book };
+    size_t nb = line_block_encode(ls->pending, ls->n, &h, buf);
+    if (line_block_verify(&h, buf, ls->pending) != 0) {
+        fprintf(stderr, "line block for player %u at book %u failed its round-trip check\n",
+                ls->player, ls->book);
+        return -1;
+    }
+    s->npoints += ls->n;
+    s->payload_bytes += nb;
+    ls->n = 0;
+    return fwrite(&h, sizeof h, 1, s->out) == 1 && fwrite(buf, 1, nb, s->out) == nb ? 0 : -1;
+}
+
+/* Reopens an indexed store for appending: drops any torn tail, writes the
+ * file header if the store is new, and seeds every series' last ts. */
+static int line_store_begin_append(LineStore *s, const char *path) {
+    if (s->map && truncate(path, (off_t)s->valid_end) != 0) { perror(path); return -1; }
+    s->out = fopen(path, s->map ? "ab" : "wb");
+    if (!s->out) { perror(path); return -1; }
+    if (!s->map) {
+        AlinesHeader fh = { ALINES_MAGIC, ALINES_VERSION, 0 };
+        if (fwrite(&fh, sizeof fh, 1, s->out) != 1) { perror(path); return -1; }
+    }
+    for (size_t b = 0; b < s->nblocks; ++b) {
+        LineSeries *ls = line_series_get(s, s->blocks[b].player, s->blocks[b].book);
+        if (!ls) return -1;
+        if (s->blocks[b].ts_max > ls->last_ts) ls->last_ts = s->blocks[b].ts_max;
+    }
+    return 0;
+}
+
+/* Undoes an append: drops the pending points and cuts the file back to the
+ * end of the valid records found at open. Always returns -1. */
+static int line_store_abort_append(LineStore *s, const char *path) {
+    for (size_t i = 0; i < s->nseries; ++i) s->series[i].n = 0;
+    if (s->out) fclose(s->out);
+    s->out = NULL;
+    if (truncate(path, (off_t)s->valid_end) != 0) perror(path);
+    return -1;
+}
+
+/* One row of a line-history CSV. */
+typedef struct {
+    const char *player_name;
+    const char *book;
+    int64_t ts;
+    double line_ast;
+    double over_odds, under_odds;
+} LineRow;
+
+static const CsvField LINE_FIELDS[] = {
+    { "ts",          CSV_I64, offsetof(LineRow, ts), 1 },
+    { "player_name", CSV_STR, offsetof(LineRow, player_name), 1 },
+    { "book",        CSV_STR, offsetof(LineRow, book), 1 },
+    { "line_ast",    CSV_F64, offsetof(LineRow, line_ast), 1 },
+    { "over_odds",   CSV_F64, offsetof(LineRow, over_odds), 1 },
+    { "under_odds",  CSV_F64, offsetof(LineRow, under_odds), 1 },
+};
+#define N_LINE_FIELDS (sizeof(LINE_FIELDS) / sizeof(LINE_FIELDS[0]))
+
+/* Two string cells per row: alternate between two scratch buffers. */
+typedef struct {
+    char buf[2][128];
+    int next;
+} CsvScratch2;
+
+static const char *csv_scratch2(void *ctx, const char *p, size_t len) {
+    CsvScratch2 *s = ctx;
+    char *buf = s->buf[s->next++ & 1];
+    return csv_name_scratch(buf, p, len);
+}
+
+/* Quantizes a CSV row; -1 if the line is not on a half point or a value
+ * is out of range. */
+static int line_point_from_row(const LineRow *r, LinePoint *p) {
+    double q = r->line_ast * 2.0;
+    if (ts_to_minutes(r->ts, &p->ts) != 0 || !(fabs(q) <= LINE_VALUE_MAX) || q != floor(q) ||
+        !(fabs(r->over_odds) <= LINE_VALUE_MAX) || r->over_odds != floor(r->over_odds) ||
+        !(fabs(r->under_odds) <= LINE_VALUE_MAX) || r->under_odds != floor(r->under_odds)) return -1;
+    p->line = (int16_t)q;
+    p->over = (int16_t)r->over_odds;
+    p->under = (int16_t)r->under_odds;
+    return 0;
+}
+
+/* Appends the rows of `csv_path`. Each series must stay in time order,
+ * also across appends. Returns 0, or -1 with the store left as it was. */
+static int line_store_append_csv(LineStore *s, const char *path, const char *csv_path, size_t *rows) {
+    if (line_store_begin_append(s, path) != 0) return -1;
+    CsvReader r;
+    CsvScratch2 scratch;
+    if (csv_open(&r, csv_path, LINE_FIELDS, N_LINE_FIELDS, csv_scratch2, &scratch) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return line_store_abort_append(s, path);
+    }
+    int rc, ok = 1;
+    LineRow row;
+    for (;;) {
+        scratch.next = 0;
+        if ((rc = csv_next(&r, &row)) != 1) break;
+        LinePoint p;
+        if (line_point_from_row(&row, &p) != 0) {
+            snprintf(r.err, sizeof r.err, "line %zu: bad ts, half-point line or odds", r.line - 1);
+            rc = -1;
+            break;
+        }
+        uint32_t np = s->players.count, nb = s->books.count;
+        uint32_t player = strtab_intern(&s->players, row.player_name, strlen(row.player_name));
+        uint32_t book = strtab_intern(&s->books, row.book, strlen(row.book));
+        LineSeries *ls = player == STRTAB_NONE || book == STRTAB_NONE ? NULL : line_series_get(s, player, book);
+        if (!ls) { snprintf(r.err, sizeof r.err, "out of memory"); rc = -1; break; }
+        if (player == np) ok = ok && line_write_name(s, LINE_NAMES_PLAYER, player, row.player_name) == 0;
+        if (book == nb) ok = ok && line_write_name(s, LINE_NAMES_BOOK, book, row.book) == 0;
+        if (p.ts < ls->last_ts) {
+            snprintf(r.err, sizeof r.err, "line %zu: %s at %s goes back in time", r.line - 1,
+                     row.player_name, row.book);
+            rc = -1;
+            break;
+        }
+        ls->last_ts = p.ts;
+        ls->pending[ls->n++] = p;
+        if (ls->n == LINE_BLOCK) ok = ok && line_series_flush(s, ls) == 0;
+        ++*rows;
+        if (*rows % 65536 == 0) csv_release(&r);
+    }
+    if (rc < 0) fprintf(stderr, "%s: %s\n", csv_path, r.err);
+    csv_close(&r);
+    if (rc < 0) return line_store_abort_append(s, path);
+    for (size_t i = 0; i < s->nseries; ++i) ok = ok && line_series_flush(s, &s->series[i]) == 0;
+    if (fflush(s->out) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return line_store_abort_append(s, path);
+    }
+    ok = fclose(s->out) == 0;
+    s->out = NULL;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok ? 0 : -1;
+}
+
+/* Rewrites the store with every series cut into full blocks again.
+ * Each append ends every series it touched with a block of its own, so a
+ * store fed a few points at a time is mostly block headers; compacting
+ * folds those back together. The new file replaces the old by rename. */
+static int line_store_compact(LineStore *s, const char *path) {
+    size_t plen = strlen(path);
+    char *tmp = malloc(plen + 5);
+    LinePoint *dec = malloc(LINE_BLOCK * sizeof *dec);
+    LineSeries ls = { .pending = malloc(LINE_BLOCK * sizeof(LinePoint)) };
+    int ok = tmp && dec && ls.pending;
+    if (!ok) {
+        fprintf(stderr, "out of memory compacting %s\n", path);
+        free(tmp); free(dec); free(ls.pending);
+        return -1;
+    }
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+    if (!(s->out = fopen(tmp, "wb"))) { perror(tmp); free(tmp); free(dec); free(ls.pending); return -1; }
+
+    AlinesHeader fh = { ALINES_MAGIC, ALINES_VERSION, 0 };
+    ok = fwrite(&fh, sizeof fh, 1, s->out) == 1;
+    for (uint32_t id = 0; ok && id < s->players.count; ++id)
+        ok = line_write_name(s, LINE_NAMES_PLAYER, id, strtab_name(&s->players, id)) == 0;
+    for (uint32_t id = 0; ok && id < s->books.count; ++id)
+        ok = line_write_name(s, LINE_NAMES_BOOK, id, strtab_name(&s->books, id)) == 0;
+    s->npoints = s->payload_bytes = 0;
+    for (size_t b = 0; ok && b < s->nblocks; ) {
+        ls.player = s->blocks[b].player;
+        ls.book = s->blocks[b].book;
+        for (; ok && b < s->nblocks && s->blocks[b].player == ls.player &&
+               s->blocks[b].book == ls.book; ++b) {
+            LineBlockHeader h;
+            memcpy(&h, s->map + s->blocks[b].offset, sizeof h);
+            if (line_block_decode(&h, s->map + s->blocks[b].offset + sizeof h, dec) != 0) {
+                fprintf(stderr, "%s: corrupt block at offset %llu\n", path,
+                        (unsigned long long)s->blocks[b].offset);
+                ok = 0;
+                break;
+            }
+            for (uint32_t j = 0; ok && j < h.count; ++j) {
+                ls.pending[ls.n++] = dec[j];
+                if (ls.n == LINE_BLOCK) ok = line_series_flush(s, &ls) == 0;
+            }
+        }
+        ok = ok && line_series_flush(s, &ls) == 0;
+    }
+    if (fclose(s->out) != 0) ok = 0;
+    s->out = NULL;
+    if (ok && rename(tmp, path) != 0) { perror(path); ok = 0; }
+    if (!ok) { fprintf(stderr, "%s: write failed\n", tmp); remove(tmp); }
+    free(tmp);
+    free(dec);
+    free(ls.pending);
+    return ok ? 0 : -1;
+}
+
+/*------------------------ lookups ------------------------*/
+/* Latest point of (player, book) at or before minute t. Returns 1 with
+ * *out set, 0 if the series has none that early, -1 on OOM, -2 if the
+ * block does not decode. */
+static int line_store_asof(LineStore *s, uint32_t player, uint32_t book, int64_t t, LinePoint *out) {
+    size_t lo = 0, hi = s->nblocks;
+    while (lo < hi) {            /* first block after (player, book, t) */
+        size_t mid = lo + (hi - lo) / 2;
+        const LineBlockRef *b = &s->blocks[mid];
+        int after = b->player != player ? b->player > player
+                  : b->book != book ? b->book > book : b->ts_min > t;
+        if (after) hi = mid;
+        else lo = mid + 1;
+    }
+    if (lo == 0) return 0;
+    const LineBlockRef *b = &s->blocks[lo - 1];
+    if (b->player != player || b->book != book) return 0;
+    if (t >= b->ts_max) { *out = b->last; return 1; }
+
+    size_t slot = (lo - 1) % LINE_CACHE;
+    if (!s->cache && !(s->cache = malloc(LINE_CACHE * LINE_BLOCK * sizeof *s->cache))) return -1;
+    LinePoint *p = s->cache + slot * LINE_BLOCK;
+    LineBlockHeader h;
+    memcpy(&h, s->map + b->offset, sizeof h);
+    if (s->cache_block[slot] != lo) {
+        if (line_block_decode(&h, s->map + b->offset + sizeof h, p) != 0) {
+            s->cache_block[slot] = 0;
+            return -2;
+        }
+        s->cache_block[slot] = lo;
+    }
+    size_t a = 0, z = h.count;    /* last point with ts <= t; p[0].ts <= t */
+    while (z - a > 1) {
+        size_t mid = a + (z - a) / 2;
+        if (p[mid].ts <= t) a = mid;
+        else z = mid;
+    }
+    *out = p[a];
+    return 1;
+}
+
+/*======================== AS-OF JOIN ========================*/
+/* Pairs each historical odds snapshot with the form features that were
+ * known when it was taken, for backtests without look-ahead. Both inputs
+ * are time-ordered CSVs:
+ *
+ *   snapshots  a slate CSV minus the form columns, plus ts (yyyymmddHHMM);
+ *              season, actual_ast, over_odds and under_odds pass through
+ *   game log   the --form-update format; a game counts as known at its
+ *              final_ts, or at the end of game_date (2359) without one
+ *
+ * It is a sort-merge: before each snapshot, every game known at or before
+ * its ts is applied to a FormStore, and the snapshot's form columns come
+ * from its player's state at that point. Each row of either file is read
+ * once, so the join is O(n + m). Memory is one PlayerForm per player plus
+ * the output buffer. Both mappings are released as they are consumed, so
+ * multi-season files stream. Snapshots whose player has no earlier game
+ * (this season, when the snapshot has one) are skipped.
+ *
+ * With a line store, line_ast, over_odds and under_odds are not read from
+ * the snapshots. They come from the book's newest quote at or before ts,
+ * and snapshots with no quote yet are skipped too. */
+#define ASOF_RELEASE_ROWS 65536
+
+typedef struct {
+    Inputs in;
+    int64_t ts;
+    int season;
+    double actual_ast, over_odds, under_odds;
+} SnapshotRow;
+
+static int64_t game_known_ts(const GameLogRow *g) {
+    return g->final_ts > 0 ? g->final_ts : (int64_t)g->game_date * 10000 + 2359;
+}
+
+static void ob_csv_cell(OutBuf *ob, const CsvField *f, const void *row) {
+    const char *p = (const char *)row + f->offset;
+    char buf[32];
+    if (f->type == CSV_STR) {
+        ob_csv_str(ob, *(const char *const *)p, ',');
+    } else if (f->type == CSV_F64) {
+        ob_f64(ob, *(const double *)p);
+    } else if (f->type == CSV_I32) {
+        ob_write(ob, buf, (size_t)snprintf(buf, sizeof buf, "%d", *(const int *)p));
+    } else {
+        ob_write(ob, buf, (size_t)snprintf(buf, sizeof buf, "%lld", (long long)*(const int64_t *)p));
+    }
+}
+
+/* Streams the joined rows to `ob` as a slate CSV (ts first, pass-through
+ * columns last, when the snapshots have them). `lines` may be NULL.
+ * Returns 0 or -1. */
+static int asof_join(const char *snap_path, const char *log_path, FormStore *store,
+                     LineStore *lines, uint32_t book, OutBuf *ob, size_t *joined, size_t *skipped) {
+    enum { N_EXTRA = 5 };
+    CsvField fields[N_SLATE_FIELDS + N_EXTRA];
+    for (size_t k = 0; k < N_SLATE_FIELDS; ++k) {
+        fields[k] = SLATE_FIELDS[k];
+        fields[k].offset += offsetof(SnapshotRow, in);
+        if (is_form_input(SLATE_FIELDS[k].offset)) fields[k].required = 0;
+        if (lines && SLATE_FIELDS[k].offset == offsetof(Inputs, line_ast)) fields[k].required = 0;
+    }
+    CsvField *extra = fields + N_SLATE_FIELDS;
+    extra[0] = (CsvField){ "ts",         CSV_I64, offsetof(SnapshotRow, ts), 1 };
+    extra[1] = (CsvField){ "season",     CSV_I32, offsetof(SnapshotRow, season), 0 };
+    extra[2] = (CsvField){ "actual_ast", CSV_F64, offsetof(SnapshotRow, actual_ast), 0 };
+    extra[3] = (CsvField){ "over_odds",  CSV_F64, offsetof(SnapshotRow, over_odds), 0 };
+    extra[4] = (CsvField){ "under_odds", CSV_F64, offsetof(SnapshotRow, under_odds), 0 };
+
+    CsvReader sr, lr;
+    char snap_name[128], log_name[128];
+    if (csv_open(&sr, snap_path, fields, N_SLATE_FIELDS + N_EXTRA, csv_name_scratch, snap_name) != 0) {
+        fprintf(stderr, "%s\n", sr.err);
+        return -1;
+    }
+    if (csv_open(&lr, log_path, GAME_LOG_FIELDS, N_GAME_LOG_FIELDS, csv_name_scratch, log_name) != 0) {
+        fprintf(stderr, "%s\n", lr.err);
+        csv_close(&sr);
+        return -1;
+    }
+    /* Pass-through columns are written only if the snapshots have them. */
+    int present[N_EXTRA] = {0};
+    for (int c = 0; c < sr.ncols; ++c)
+        if (sr.col_field[c] >= (int)N_SLATE_FIELDS) present[sr.col_field[c] - N_SLATE_FIELDS] = 1;
+    if (lines) present[3] = present[4] = 1;
+
+    ob_puts(ob, "ts");
+    for (size_t k = 0; k < N_SLATE_FIELDS; ++k) { ob_puts(ob, ","); ob_puts(ob, SLATE_FIELDS[k].name); }
+    for (int e = 1; e < N_EXTRA; ++e)
+        if (present[e]) { ob_puts(ob, ","); ob_puts(ob, extra[e].name); }
+    ob_puts(ob, "\n");
+
+    GameLogRow g = {0};
+    int lrc = csv_next(&lr, &g), src = 0;
+    int64_t last_snap = INT64_MIN, last_game = INT64_MIN;
+    SnapshotRow s;
+    const char *bad = NULL;
+    while (lrc >= 0 && (src = csv_next(&sr, &s)) == 1) {
+        if (s.ts < last_snap) { bad = snap_path; break; }
+        last_snap = s.ts;
+        while (lrc == 1 && game_known_ts(&g) <= s.ts) {
+            if (game_known_ts(&g) < last_game) { bad = log_path; break; }
+            last_game = game_known_ts(&g);
+            PlayerForm *f = form_store_get(store, log_name, strlen(log_name));
+            if (!f) { fprintf(stderr, "out of memory after %u players\n", store->names.count); goto fail; }
+            form_push(f, &g, store->decay);
+            g.final_ts = 0;
+            lrc = csv_next(&lr, &g);
+        }
+        if (bad) break;
+
+        const PlayerForm *f = form_store_find(store, snap_name);
+        int quoted = 1;
+        if (lines) {
+            int64_t t;
+            LinePoint q;
+            uint32_t player = strtab_find(&lines->players, snap_name);
+            if (ts_to_minutes(s.ts, &t) != 0) {
+                snprintf(sr.err, sizeof sr.err, "line %zu: bad ts %lld", sr.line - 1, (long long)s.ts);
+                src = -1;
+                break;
+            }
+            int got = player != STRTAB_NONE ? line_store_asof(lines, player, book, t, &q) : 0;
+            if (got == -1) { fprintf(stderr, "out of memory reading the line store\n"); goto fail; }
+            if (got < 0) {
+                fprintf(stderr, "line store: cannot decode the line block of %s\n", snap_name);
+                goto fail;
+            }
+            quoted = got == 1;
+            if (quoted) {
+                s.in.line_ast = q.line / 2.0;
+                s.over_odds = q.over;
+                s.under_odds = q.under;
+            }
+        }
+        if (!quoted || !f || !f->games || (present[1] && f->season != s.season)) {
+            ++*skipped;
+        } else {
+            form_fill(f, store->mode, &s.in);
+            ob_csv_cell(ob, &extra[0], &s);
+            for (size_t k = 0; k < N_SLATE_FIELDS; ++k) { ob_puts(ob, ","); ob_csv_cell(ob, &fields[k], &s); }
+            for (int e = 1; e < N_EXTRA; ++e)
+                if (present[e]) { ob_puts(ob, ","); ob_csv_cell(ob, &extra[e], &s); }
+            ob_puts(ob, "\n");
+            ++*joined;
+        }
+        if ((*joined + *skipped) % ASOF_RELEASE_ROWS == 0) {
+            csv_release(&sr);
+            csv_release(&lr);
+        }
+    }
+    if (bad) {
+        fprintf(stderr, "%s: not in time order (line %zu)\n", bad, bad == snap_path ? sr.line - 1 : lr.line - 1);
+        goto fail;
+    }
+    if (lrc < 0 || src < 0) {
+        fprintf(stderr, "%s: %s\n", lrc < 0 ? log_path : snap_path, lrc < 0 ? lr.err : sr.err);
+        goto fail;
+    }
+    csv_close(&sr);
+    csv_close(&lr);
+    return 0;
+
+fail:
+    csv_close(&sr);
+    csv_close(&lr);
+    return -1;
+}
+
+/*======================== LINE SHOPPING ========================*/
+/* Scores every book's line for a player against a single projection.
+ * Books quote the same player at different lines and prices, but only
+ * base_assists() reads line_ast, so the slate is projected once with the
+ * consensus (median) book line in its place. Then, per slate row:
+ *
+ *   - one assist_cdf() pass over the row's book lines, sorted, gives
+ *     p_over/p_under/p_push at every book (as in price_ladder());
+ *   - a flat pass over the quote columns turns those into the expected
+ *     profit per unit staked on each side, p_win * payout - p_lose;
+ *   - the best over and the best under are picked.
+ *
+ * Quotes come from a CSV (player_name, book, line_ast, over_odds,
+ * under_odds, optional ts) or from a line store, as every book's newest
+ * line at or before a given time. A book quoted more than once for a
+ * player counts once, at its newest ts (the later row on a tie), so a
+ * line-history CSV gives the same quotes as the store built from it. A
+ * player listed on several slate rows is priced on the first of them. */
+#define SHOP_MAX_QUOTES 64       /* per player */
+#define SHOP_NONE SIZE_MAX
+
+typedef struct {
+    const char *path;            /* quotes CSV, or a .alines line store */
+    int64_t at;                  /* store only: yyyymmddHHMM, 0 = newest */
+} ShopOptions;
+
+typedef struct {
+    uint32_t row, book;
+    double line, over_odds, under_odds;
+    int64_t ts;                  /* yyyymmddHHMM, 0 if not given */
+    size_t seq;                  /* order read, breaks ts ties */
+} ShopQuote;
+
+typedef struct {
+    ShopQuote *q;
+    size_t n, cap;
+} ShopList;
+
+/* Quotes grouped by slate row, ascending line within a row. */
+typedef struct {
+    size_t n, nrows;
+    size_t *start;               /* row i: quotes [start[i], start[i + 1]) */
+    uint32_t *book;
+    double *line, *over_odds, *under_odds;
+    double *pay_over, *pay_under;    /* profit on a one-unit win */
+    double *p_over, *p_under, *p_push;
+    double *ev_over, *ev_under;      /* expected profit per unit staked */
+    void *block;
+    StrTab books;
+} ShopQuotes;
+
+typedef struct {
+    size_t over, under;          /* best quote on each side, or SHOP_NONE */
+} ShopPick;
+
+static void shop_quotes_free(ShopQuotes *q) {
+    free(q->block);
+    free(q->start);
+    strtab_free(&q->books);
+    memset(q, 0, sizeof *q);
+}
+
+static int shop_list_push(ShopList *l, const ShopQuote *q) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 256;
+        ShopQuote *p = realloc(l->q, cap * sizeof *p);
+        if (!p) return -1;
+        l->q = p;
+        l->cap = cap;
+    }
+    l->q[l->n++] = *q;
+    return 0;
+}
+
+static int shop_pair_cmp(const void *a, const void *b) {
+    const ShopQuote *x = a, *y = b;
+    if (x->row != y->row) return x->row < y->row ? -1 : 1;
+    if (x->book != y->book) return x->book < y->book ? -1 : 1;
+    if (x->ts != y->ts) return x->ts < y->ts ? -1 : 1;
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+/* Keeps the newest quote of each (row, book); returns the new count. */
+static size_t shop_keep_newest(ShopQuote *q, size_t n) {
+    size_t k = 0;
+    qsort(q, n, sizeof *q, shop_pair_cmp);
+    for (size_t j = 0; j < n; ++j) {
+        if (j + 1 < n && q[j + 1].row == q[j].row && q[j + 1].book == q[j].book) continue;
+        q[k++] = q[j];
+    }
+    return k;
+}
+
+static int shop_quote_cmp(const void *a, const void *b) {
+    const ShopQuote *x = a, *y = b;
+    if (x->row != y->row) return x->row < y->row ? -1 : 1;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return x->book < y->book ? -1 : x->book > y->book;
+}
+
+/* Reads a quotes CSV: the line-history columns, ts optional. Players not
+ * on the slate are ignored. */
+static int shop_read_csv(const char *path, const InputsSoA *cols, const uint32_t *row_of,
+                         StrTab *books, ShopList *l) {
+    CsvField fields[N_LINE_FIELDS];
+    memcpy(fields, LINE_FIELDS, sizeof fields);
+    for (size_t k = 0; k < N_LINE_FIELDS; ++k)
+        if (fields[k].offset == offsetof(LineRow, ts)) fields[k].required = 0;
+    CsvReader r;
+    CsvScratch2 scratch;
+    if (csv_open(&r, path, fields, N_LINE_FIELDS, csv_scratch2, &scratch) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return -1;
+    }
+    int rc;
+    LineRow row;
+    for (;;) {
+        scratch.next = 0;
+        row.ts = 0;
+        if ((rc = csv_next(&r, &row)) != 1) break;
+        uint32_t id = strtab_find(cols->names, row.player_name);
+        if (id == STRTAB_NONE || row_of[id] == UINT32_MAX) continue;
+        if (!(fabs(row.over_odds) >= 100.0) || !(fabs(row.under_odds) >= 100.0)) {
+            snprintf(r.err, sizeof r.err, "line %zu: odds are American, at least 100 either way",
+                     r.line - 1);
+            rc = -1;
+            break;
+        }
+        ShopQuote q = { row_of[id], strtab_intern(books, row.book, strlen(row.book)),
+                        row.line_ast, row.over_odds, row.under_odds, row.ts, l->n };
+        if (q.book == STRTAB_NONE || shop_list_push(l, &q) != 0) {
+            snprintf(r.err, sizeof r.err, "out of memory");
+            rc = -1;
+            break;
+        }
+    }
+    if (rc < 0) fprintf(stderr, "%s: %s\n", path, r.err);
+    csv_close(&r);
+    return rc < 0 ? -1 : 0;
+}
+
+/* Every book's newest line for each slate player at or before `at`.
+ * Points without a usable price (|odds| < 100) are left out. */
+static int shop_read_store(const char *path, int64_t at, const InputsSoA *cols,
+                           const uint32_t *row_of, StrTab *books, ShopList *l) {
+    LineStore s;
+    int64_t t = INT64_MAX;
+    if (at && ts_to_minutes(at, &t) != 0) {
+        fprintf(stderr, "--at %lld: not a yyyymmddHHMM time\n", (long long)at);
+        return -1;
+    }
+    if (line_store_open(&s, path) != 0) return -1;
+    int rc = 0;
+    for (uint32_t p = 0; p < s.players.count && rc == 0; ++p) {
+        uint32_t id = strtab_find(cols->names, strtab_name(&s.players, p));
+        if (id == STRTAB_NONE || row_of[id] == UINT32_MAX) continue;
+        for (uint32_t b = 0; b < s.books.count && rc == 0; ++b) {
+            LinePoint pt;
+            int got = line_store_asof(&s, p, b, t, &pt);
+            if (got == -2) {
+                fprintf(stderr, "%s: cannot decode the %s line block of %s\n", path,
+                        strtab_name(&s.books, b), strtab_name(&s.players, p));
+                rc = -2;
+                break;
+            }
+            if (got == 0 || (got > 0 && (abs(pt.over) < 100 || abs(pt.under) < 100))) continue;
+            const char *name = strtab_name(&s.books, b);
+            ShopQuote q = { row_of[id], strtab_intern(books, name, strlen(name)),
+                            pt.line * 0.5, pt.over, pt.under, minutes_to_ts(pt.ts), l->n };
+            if (got < 0 || q.book == STRTAB_NONE || shop_list_push(l, &q) != 0) rc = -1;
+        }
+    }
+    if (rc == -1) fprintf(stderr, "%s: out of memory\n", path);
+    line_store_close(&s);
+    return rc;
+}
+
+/* Reads the quotes for the slate's players and lays them out by row. */
+static int shop_load(ShopQuotes *q, const ShopOptions *opt, const InputsSoA *cols) {
+    ShopList l = {0};
+    uint32_t nnames = cols->names->count;
+    uint32_t *row_of = malloc((nnames ? nnames : 1) * sizeof *row_of);
+    int rc = -1;
+    memset(q, 0, sizeof *q);
+    if (!(q->start = calloc(cols->n + 1, sizeof *q->start)) || !row_of) {
+        fprintf(stderr, "out of memory for %zu players\n", cols->n);
+        goto done;
+    }
+    for (uint32_t id = 0; id < nnames; ++id) row_of[id] = UINT32_MAX;
+    for (size_t i = cols->n; i-- > 0; ) row_of[cols->player_id[i]] = (uint32_t)i;
+
+    if ((has_suffix(opt->path, ".alines")
+             ? shop_read_store(opt->path, opt->at, cols, row_of, &q->books, &l)
+             : shop_read_csv(opt->path, cols, row_of, &q->books, &l)) != 0) goto done;
+    l.n = shop_keep_newest(l.q, l.n);
+    qsort(l.q, l.n, sizeof *l.q, shop_quote_cmp);
+
+    void **cc[] = {
+        (void **)&q->book, (void **)&q->line, (void **)&q->over_odds, (void **)&q->under_odds,
+        (void **)&q->pay_over, (void **)&q->pay_under, (void **)&q->p_over,
+        (void **)&q->p_under, (void **)&q->p_push, (void **)&q->ev_over, (void **)&q->ev_under,
+    };
+    const size_t D = sizeof(double);
+    const size_t elem[] = { sizeof(uint32_t), D, D, D, D, D, D, D, D, D, D };
+    if (!(q->block = soa_carve(l.n, elem, cc, (int)(sizeof(elem) / sizeof(elem[0]))))) {
+        fprintf(stderr, "out of memory for %zu quotes\n", l.n);
+        goto done;
+    }
+    q->n = l.n;
+    q->nrows = cols->n;
+    for (size_t j = 0; j < l.n; ++j) {
+        const ShopQuote *s = &l.q[j];
+        if (++q->start[s->row + 1] > SHOP_MAX_QUOTES) {
+            fprintf(stderr, "%s: more than %d quotes for %s\n", opt->path, SHOP_MAX_QUOTES,
+                    strtab_name(cols->names, cols->player_id[s->row]));
+            goto done;
+        }
+        q->book[j] = s->book;
+        q->line[j] = s->line;
+        q->over_odds[j] = s->over_odds;
+        q->under_odds[j] = s->under_odds;
+        q->pay_over[j] = bt_payout(s->over_odds);
+        q->pay_under[j] = bt_payout(s->under_odds);
+    }
+    for (size_t i = 0; i < cols->n; ++i) q->start[i + 1] += q->start[i];
+    rc = 0;
+
+done:
+    free(row_of);
+    free(l.q);
+    if (rc != 0) shop_quotes_free(q);
+    return rc;
+}
+
+/* The line each row is projected from: the median of its book lines, or
+ * the slate's own line_ast where no book quotes the player. */
+static void shop_consensus(const ShopQuotes *q, const InputsSoA *cols, double *line) {
+    for (size_t i = 0; i < cols->n; ++i) {
+        size_t a = q->start[i], n = q->start[i + 1] - a, m = a + n / 2;
+        line[i] = n == 0 ? cols->line_ast[i]
+                : (n & 1) ? q->line[m] : 0.5 * (q->line[m - 1] + q->line[m]);
+    }
+}
+
+/* One CDF pass prices all of a row's quotes. Their lines are ascending,
+ * so after dropping repeats (books often agree) the CDF points are too. */
+static void shop_price_row(ShopQuotes *q, size_t a, size_t b, double mu) {
+    double k[2 * SHOP_MAX_QUOTES], cdf[2 * SHOP_MAX_QUOTES];
+    size_t n = b - a;
+    int nk = 0;
+    if (n == 0) return;
+    if (isnan(mu)) {
+        for (size_t j = a; j < b; ++j) q->p_over[j] = q->p_under[j] = q->p_push[j] = NAN;
+        return;
+    }
+    for (size_t j = 0; j < n; ++j) {
+        double line = q->line[a + j];
+        if (j && line == q->line[a + j - 1]) continue;
+        k[nk++] = ceil(line) - 1.0;
+        k[nk++] = floor(line);
+    }
+    assist_cdf(mu, line_dispersion, k, nk, cdf);
+    for (size_t j = a, t = 0; j < b; ++j) {
+        if (j > a && q->line[j] != q->line[j - 1]) t += 2;
+        q->p_under[j] = cdf[t];
+        q->p_push[j] = cdf[t + 1] - cdf[t];
+        q->p_over[j] = 1.0 - cdf[t + 1];
+    }
+}
+
+/* Expected profit per unit staked on each side; a push refunds. */
+static void shop_ev_col(const double *p_over, const double *p_under,
+                        const double *pay_over, const double *pay_under,
+                        double *ev_over, double *ev_under, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        ev_over[i] = p_over[i] * pay_over[i] - p_under[i];
+        ev_under[i] = p_under[i] * pay_under[i] - p_over[i];
+    }
+}
+
+typedef struct {
+    const double *projection;
+    ShopQuotes *q;
+    ShopPick *pick;
+} ShopJob;
+
+static void shop_task(void *ctx, size_t task, int worker) {
+    (void)worker;
+    ShopJob *job = ctx;
+    ShopQuotes *q = job->q;
+    size_t lo = task * BATCH_CHUNK;
+    size_t hi = lo + BATCH_CHUNK < q->nrows ? lo + BATCH_CHUNK : q->nrows;
+    for (size_t i = lo; i < hi; ++i)
+        shop_price_row(q, q->start[i], q->start[i + 1], job->projection[i]);
+    size_t a = q->start[lo];
+    shop_ev_col(q->p_over + a, q->p_under + a, q->pay_over + a, q->pay_under + a,
+                q->ev_over + a, q->ev_under + a, q->start[hi] - a);
+    /* Ties go to the better line: the lowest over, the highest under. */
+    for (size_t i = lo; i < hi; ++i) {
+        ShopPick *p = &job->pick[i];
+        double over = -INFINITY, under = -INFINITY;
+        p->over = p->under = SHOP_NONE;
+        for (size_t j = q->start[i]; j < q->start[i + 1]; ++j)
+            if (q->ev_over[j] > over) { over = q->ev_over[j]; p->over = j; }
+        for (size_t j = q->start[i + 1]; j-- > q->start[i]; )
+            if (q->ev_under[j] > under) { under = q->ev_under[j]; p->under = j; }
+    }
+}
+
+/* Prices every quote against its row's projection and picks each row's
+ * best over and best under. */
+static void shop_lines(ThreadPool *pool, const OutputSoA *res, ShopQuotes *q, ShopPick *pick) {
+    ShopJob job = { res->projection, q, pick };
+    pool_run(pool, (q->nrows + BATCH_CHUNK - 1) / BATCH_CHUNK, shop_task, &job);
+}
+
+/* One row per quoted player. csv/tsv/json only. */
+#define SHOP_SIDE_FIELDS(X, s) X(s##_book) X(s##_line) X(s##_odds) X(p_##s) X(ev_##s)
+
+static void write_shop_header(OutBuf *ob, OutFormat fmt) {
+    if (fmt == OUT_JSON) return;
+    const char *sep = fmt == OUT_CSV ? "," : "\t";
+    ob_puts(ob, "player_name");
+#define HEAD(f) ob_puts(ob, sep); ob_puts(ob, #f);
+    HEAD(projection) HEAD(consensus_line) HEAD(books)
+    SHOP_SIDE_FIELDS(HEAD, over) SHOP_SIDE_FIELDS(HEAD, under)
+#undef HEAD
+    ob_puts(ob, "\n");
+}
+
+static void write_shop_row(OutBuf *ob, OutFormat fmt, const char *name, double projection,
+                           double consensus, const ShopQuotes *q, size_t i, const ShopPick *p) {
+#define NAME(f) #f,
+    static const char *const keys[2][5] = {
+        { SHOP_SIDE_FIELDS(NAME, over) }, { SHOP_SIDE_FIELDS(NAME, under) },
+    };
+#undef NAME
+    size_t best[2] = { p->over, p->under };
+    double v[2][4];
+    for (int s = 0; s < 2; ++s) {
+        size_t j = best[s];
+        v[s][0] = j == SHOP_NONE ? NAN : q->line[j];
+        v[s][1] = j == SHOP_NONE ? NAN : s ? q->under_odds[j] : q->over_odds[j];
+        v[s][2] = j == SHOP_NONE ? NAN : s ? q->p_under[j] : q->p_over[j];
+        v[s][3] = j == SHOP_NONE ? NAN : s ? q->ev_under[j] : q->ev_over[j];
+    }
+    const double head[3] = { projection, consensus, (double)(q->start[i + 1] - q->start[i]) };
+    if (fmt == OUT_JSON) {
+        static const char *const head_keys[3] = { "projection", "consensus_line", "books" };
+        ob_puts(ob, "{\"player_name\":");
+        ob_json_str(ob, name);
+        for (int f = 0; f < 3; ++f) {
+            ob_puts(ob, ",\""); ob_puts(ob, head_keys[f]); ob_puts(ob, "\":");
+            ob_json_f64(ob, head[f]);
+        }
+        for (int s = 0; s < 2; ++s) {
+            ob_puts(ob, ",\""); ob_puts(ob, keys[s][0]); ob_puts(ob, "\":");
+            if (best[s] == SHOP_NONE) ob_puts(ob, "null");
+            else ob_json_str(ob, strtab_name(&q->books, q->book[best[s]]));
+            for (int f = 0; f < 4; ++f) {
+                ob_puts(ob, ",\""); ob_puts(ob, keys[s][f + 1]); ob_puts(ob, "\":");
+                ob_json_f64(ob, v[s][f]);
+            }
+        }
+        ob_puts(ob, "}\n");
+        return;
+    }
+    char sep = fmt == OUT_CSV ? ',' : '\t';
+    ob_csv_str(ob, name, sep);
+    for (int f = 0; f < 3; ++f) {
+        ob_write(ob, &sep, 1);
+        ob_f64(ob, head[f]);
+    }
+    for (int s = 0; s < 2; ++s) {
+        ob_write(ob, &sep, 1);
+        if (best[s] != SHOP_NONE) ob_csv_str(ob, strtab_name(&q->books, q->book[best[s]]), sep);
+        for (int f = 0; f < 4; ++f) {
+            ob_write(ob, &sep, 1);
+            ob_f64(ob, v[s][f]);
+        }
+    }
+    ob_puts(ob, "\n");
+}
+
+/*======================== NDJSON STREAMING ========================*/
+/* One flat JSON object per input line, keyed by the Inputs field names
+ * (the same bindings as the CSV header), one projection object per output
+ * line. Unknown keys are skipped; is_home / is_back_to_back accept numbers
+ * or true/false. A bad line yields {"error": ..., "line": N} so output stays
+ * line-for-line with input. Output is flushed whenever the input has no
+ * complete line left, so a trickle of records sees per-record latency and
+ * a flood gets full buffers. */
+#define NDJSON_MAX_LINE (1 << 16)
+
+static void js_ws(const char **p, const char *end) {
+    while (*p < end && (**p == ' ' || **p == '\t' || **p == '\r' || **p == '\n')) ++*p;
+}
+
+static int js_hex4(const char *p, const char *end, unsigned *out) {
+    if (end - p < 4) return -1;
+    unsigned v = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/* Decodes the string at *p (which must be '"') into dst, truncating at
+ * cap-1 bytes and NUL-terminating. dst may be NULL to just skip it. */
+static int js_string(const char **p, const char *end, char *dst, size_t cap) {
+    const char *s = *p + 1;
+    size_t len = 0;
+#define JS_PUT(ch) do { if (dst && len + 1 < cap) dst[len] = (char)(ch); ++len; } while (0)
+    for (;;) {
+        if (s >= end) return -1;
+        char c = *s++;
+        if (c == '"') break;
+        if (c != '\\') { JS_PUT(c); continue; }
+        if (s >= end) return -1;
+        c = *s++;
+        switch (c) {
+        case '"': case '\\': case '/': JS_PUT(c); break;
+        case 'b': JS_PUT('\b'); break;
+        case 'f': JS_PUT('\f'); break;
+        case 'n': JS_PUT('\n'); break;
+        case 'r': JS_PUT('\r'); break;
+        case 't': JS_PUT('\t'); break;
+        case 'u': {
+            unsigned u;
+            if (js_hex4(s, end, &u) != 0) return -1;
+            s += 4;
+            if (u >= 0xD800 && u < 0xDC00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                unsigned lo;
+                if (js_hex4(s + 2, end, &lo) == 0 && lo >= 0xDC00 && lo < 0xE000) {
+                    u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+                    s += 6;
+                }
+            }
+            if (u < 0x80) { JS_PUT(u); }
+            else if (u < 0x800) { JS_PUT(0xC0 | (u >> 6)); JS_PUT(0x80 | (u & 0x3F)); }
+            else if (u < 0x10000) {
+                JS_PUT(0xE0 | (u >> 12)); JS_PUT(0x80 | ((u >> 6) & 0x3F)); JS_PUT(0x80 | (u & 0x3F));
+            } else {
+                JS_PUT(0xF0 | (u >> 18)); JS_PUT(0x80 | ((u >> 12) & 0x3F));
+                JS_PUT(0x80 | ((u >> 6) & 0x3F)); JS_PUT(0x80 | (u & 0x3F));
+            }
+            break;
+        }
+        default: return -1;
+        }
+    }
+#undef JS_PUT
+    if (dst && cap) dst[len < cap ? len : cap - 1] = 0;
+    *p = s;
+    return 0;
+}
+
+static int js_skip_value(const char **p, const char *end) {
+    int depth = 0;
+    do {
+        js_ws(p, end);
+        if (*p >= end) return -1;
+        char c = **p;
+        if (c == '"') {
+            if (js_string(p, end, NULL, 0) != 0) return -1;
+        } else if (c == '{' || c == '[') {
+            ++depth; ++*p;
+        } else if (c == '}' || c == ']') {
+            if (--depth < 0) return -1;
+            ++*p;
+        } else if (c == ',' || c == ':') {
+            if (depth == 0) return -1;
+            ++*p;
+        } else {
+            const char *s = *p;
+            while (*p < end && **p != ',' && **p != '}' && **p != ']' &&
+                   **p != ' ' && **p != '\t' && **p != '\r') ++*p;
+            if (*p == s) return -1;
+        }
+    } while (depth > 0);
+    return 0;
+}
+
+static int js_literal(const char **p, const char *end, const char *lit) {
+    size_t n = strlen(lit);
+    if ((size_t)(end - *p) < n || memcmp(*p, lit, n) != 0) return 0;
+    *p += n;
+    return 1;
+}
+
+/* Parses one object line into *in (name decoded into namebuf). Returns 0,
+ * or -1 with *err pointing at a static message. */
+static int ndjson_parse(const char *p, const char *end, Inputs *in,
+                        char *namebuf, size_t namecap, const char **err) {
+    uint32_t seen = 0;
+    js_ws(&p, end);
+    if (p >= end || *p != '{') { *err = "expected a JSON object"; return -1; }
+    ++p;
+    js_ws(&p, end);
+    if (p < end && *p == '}') ++p;
+    else for (;;) {
+        char key[64];
+        js_ws(&p, end);
+        if (p >= end || *p != '"' || js_string(&p, end, key, sizeof key) != 0) {
+            *err = "expected a string key"; return -1;
+        }
+        js_ws(&p, end);
+        if (p >= end || *p++ != ':') { *err = "expected ':'"; return -1; }
+        js_ws(&p, end);
+
+        size_t f = 0;
+        while (f < N_SLATE_FIELDS && strcmp(SLATE_FIELDS[f].name, key) != 0) ++f;
+        if (f == N_SLATE_FIELDS) {
+            if (js_skip_value(&p, end) != 0) { *err = "malformed value"; return -1; }
+        } else {
+            const CsvField *fd = &SLATE_FIELDS[f];
+            char *dst = (char *)in + fd->offset;
+            if (fd->type == CSV_STR) {
+                if (p >= end || *p != '"' || js_string(&p, end, namebuf, namecap) != 0) {
+                    *err = "player_name must be a string"; return -1;
+                }
+                *(const char **)dst = namebuf;
+            } else if (fd->type == CSV_I32 && js_literal(&p, end, "true")) {
+                *(int *)dst = 1;
+            } else if (fd->type == CSV_I32 && js_literal(&p, end, "false")) {
+                *(int *)dst = 0;
+            } else {
+                double v;
+                const char *q = parse_f64(p, end, &v);
+                if (!q) { *err = "expected a number"; return -1; }
+                p = q;
+                if (fd->type == CSV_F64) *(double *)dst = v;
+                else *(int *)dst = (int)v;
+            }
+            seen |= 1u << f;
+        }
+        js_ws(&p, end);
+        if (p < end && *p == ',') { ++p; continue; }
+        if (p < end && *p == '}') { ++p; break; }
+        *err = "expected ',' or '}'";
+        return -1;
+    }
+    js_ws(&p, end);
+    if (p != end) { *err = "trailing characters after object"; return -1; }
+    for (size_t f = 0; f < N_SLATE_FIELDS; ++f) {
+        if (!(seen & (1u << f))) { *err = "missing field"; return -1; }
+    }
+    return 0;
+}
+
+static void ndjson_write_error(OutBuf *ob, const char *msg, size_t line) {
+    char *p = ob_reserve(ob, 128);
+    ob->len += (size_t)snprintf(p, 128, "{\"error\":\"%s\",\"line\":%zu}\n", msg, line);
+}
+
+static int run_ndjson(int in_fd, int out_fd) {
+    static char ibuf[1 << 20];
+    static OutBuf ob;
+    char namebuf[256];
+    size_t have = 0, line = 0, row = 0;   /* physical lines read, records written */
+    int skipping = 0;            /* inside an over-long line, its head discarded */
+
+    ob.fd = out_fd;
+    for (;;) {
+        ssize_t r = read(in_fd, ibuf + have, sizeof ibuf - have);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) { perror("read"); return 1; }
+        int eof = r == 0;
+        have += (size_t)r;
+
+        char *p = ibuf, *end = ibuf + have;
+        for (;;) {
+            char *nl = memchr(p, '\n', (size_t)(end - p));
+            if (!nl) {
+                if (!eof || (p == end && !skipping)) break;
+                nl = end;                 /* last line without a newline */
+            }
+            ++line;
+            if (skipping || nl - p > NDJSON_MAX_LINE) {
+                ndjson_write_error(&ob, "line too long", line);
+                skipping = 0;
+            } else {
+                const char *b = p, *e = nl;
+                js_ws(&b, e);
+                if (b < e) {
+                    Inputs in;
+                    const char *err;
+                    if (ndjson_parse(b, e, &in, namebuf, sizeof namebuf, &err) == 0) {
+                        Output o = project(&in);
+                        write_row(&ob, OUT_JSON, row++, in.player_name, &o);
+                    } else {
+                        ndjson_write_error(&ob, err, line);
+                    }
+                }                         /* blank lines are not records */
+            }
+            p = nl < end ? nl + 1 : end;
+        }
+
+        have = (size_t)(end - p);
+        if (have == sizeof ibuf) {        /* one line fills the buffer: drop */
+            skipping = 1;                 /* it, report it at its newline */
+            have = 0;
+        } else {
+            memmove(ibuf, p, have);
+        }
+        ob_flush(&ob);
+        if (ob.failed) return 1;
+        if (eof) return 0;
+    }
+}
+
+static void strip_newline(char *s) {
+    for (int i = 0; s[i]; ++i) { if (s[i] == '\n') { s[i] = 0; break; } }
+}
+
+/* Non-interactive slate reader: the same fields as the interactive prompts,
+ * in the same order, one player after another. The name takes a line of its
+ * own (blank lines are skipped); the 13 numbers follow, whitespace separated.
+ * Returns 1 on a full record, 0 on clean EOF, -1 on a malformed record. */
+static int read_record(FILE *fp, Inputs *in, char *namebuf, int namelen) {
+    do {
+        if (!fgets(namebuf, namelen, fp)) return 0;
+        strip_newline(namebuf);
+    } while (namebuf[strspn(namebuf, " \t\r")] == 0);
+    in->player_name = namebuf;
+
+    int got = fscanf(fp, "%lf %lf %d %lf %lf %lf %lf %lf %lf %lf %d %lf %lf",
+                     &in->line_ast, &in->season_avg_ast, &in->is_home,
+                     &in->game_total_ou, &in->team_total_ou, &in->opp_ast_allowed,
+                     &in->matchup_pace, &in->recent_avg_ast,
+                     &in->season_avg_minutes, &in->expected_minutes,
+                     &in->is_back_to_back,
+                     &in->last5_potential_ast, &in->last5_conversion);
+    if (got != 13) return -1;
+    /* consume the rest of the numbers line so the next fgets sees the name */
+    int c;
+    while ((c = fgetc(fp)) != EOF && c != '\n') {}
+    return 1;
+}
+
+static int slate_load_records(Slate *slate, FILE *fp) {
+    Inputs in;
+    char namebuf[128];
+    int rc;
+
+    while ((rc = read_record(fp, &in, namebuf, sizeof(namebuf))) == 1) {
+        if (slate_push(slate, &in) != 0) {
+            fprintf(stderr, "out of memory after %zu players\n", slate->n);
+            return -1;
+        }
+    }
+    if (rc < 0) {
+        fprintf(stderr, "malformed record for player %zu (\"%s\")\n",
+                slate->n + 1, namebuf);
+        return -1;
+    }
+    return 0;
+}
+
+/* With form_optional the form columns may be missing (see form_fill_slate()). */
+/* A slate CSV row: the inputs, plus the team when the file names it. */
+typedef struct {
+    Inputs in;
+    const char *team;
+} SlateRow;
+
+static int slate_load_csv(Slate *slate, const char *path, int form_optional) {
+    CsvReader r;
+    CsvScratch2 scratch;
+    CsvField fields[N_SLATE_FIELDS + 1];
+    for (size_t k = 0; k < N_SLATE_FIELDS; ++k) {
+        fields[k] = SLATE_FIELDS[k];
+        fields[k].offset += offsetof(SlateRow, in);
+        if (form_optional && is_form_input(SLATE_FIELDS[k].offset)) fields[k].required = 0;
+    }
+    fields[N_SLATE_FIELDS] = (CsvField){ "team", CSV_STR, offsetof(SlateRow, team), 0 };
+    if (csv_open(&r, path, fields, N_SLATE_FIELDS + 1, csv_scratch2, &scratch) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return -1;
+    }
+    if (slate_reserve(slate, slate->n + csv_rows_hint(&r)) != 0) {
+        fprintf(stderr, "out of memory sizing %s\n", path);
+        csv_close(&r);
+        return -1;
+    }
+    SlateRow row;
+    int rc;
+    for (;;) {
+        for (size_t k = 0; form_optional && k < N_FORM_INPUTS; ++k)
+            *(double *)((char *)&row.in + FORM_INPUT_OFFSETS[k]) = NAN;
+        row.team = NULL;
+        scratch.next = 0;
+        if ((rc = csv_next(&r, &row)) != 1) break;
+        uint32_t team = STRTAB_NONE;
+        if (slate_push(slate, &row.in) != 0 ||
+            (row.team && *row.team &&
+             (team = strtab_intern(&slate->names, row.team, strlen(row.team))) == STRTAB_NONE)) {
+            fprintf(stderr, "out of memory after %zu players\n", slate->n);
+            rc = -1;
+            break;
+        }
+        slate->in[slate->n - 1].team_id = team;
+    }
+    if (rc < 0 && r.err[0]) fprintf(stderr, "%s: %s\n", path, r.err);
+    csv_close(&r);
+    return rc < 0 ? -1 : 0;
+}
+
+/* Loads a text slate: NULL reads the record format from stdin, *.csv goes
+ * through the mmap CSV reader, anything else is read as the record format. */
+static int slate_load(Slate *slate, const char *path, int form_optional) {
+    if (!path) return slate_load_records(slate, stdin);
+    if (has_suffix(path, ".csv")) return slate_load_csv(slate, path, form_optional);
+    FILE *fp = fopen(path, "r");
+    if (!fp) { perror(path); return -1; }
+    int rc = slate_load_records(slate, fp);
+    fclose(fp);
+    return rc;
+}
+
+/* Columns for a batch run. An .aslate file is mapped and used in place;
+ * text slates are parsed, given their form fields from `form` if set, and
+ * transposed into owned columns. */
+typedef struct {
+    Slate slate;
+    Aslate file;
+    InputsSoA own;
+    const InputsSoA *cols;
+} SlateColumns;
+
+static int slate_columns_open(SlateColumns *sc, const char *path, const FormStore *form) {
+    memset(sc, 0, sizeof *sc);
+    if (path && has_suffix(path, ".aslate")) {
+        if (form) {
+            fprintf(stderr, "--form fills text slates; an .aslate already has its form columns\n");
+            return -1;
+        }
+        char err[256];
+        if (aslate_open(&sc->file, path, err, sizeof err) != 0) {
+            fprintf(stderr, "%s\n", err);
+            return -1;
+        }
+        sc->cols = &sc->file.view;
+        return 0;
+    }
+    if (slate_load(&sc->slate, path, form != NULL) != 0) return -1;
+    if (form && form_fill_slate(form, &sc->slate) != 0) return -1;
+    if (inputs_soa_alloc(&sc->own, sc->slate.n) != 0) {
+        fprintf(stderr, "out of memory for %zu players\n", sc->slate.n);
+        return -1;
+    }
+    inputs_to_soa(sc->slate.in, sc->slate.n, &sc->slate.names, &sc->own);
+    sc->cols = &sc->own;
+    return 0;
+}
+
+static void slate_columns_close(SlateColumns *sc) {
+    inputs_soa_free(&sc->own);
+    aslate_close(&sc->file);
+    slate_free(&sc->slate);
+}
+
+static int run_batch(const char *path, const FormStore *form, int nthreads, OutFormat fmt,
+                     int factor, int normalize, const Ladder *ladder, const SimOptions *sim,
+                     const char *sim_out, const ShopOptions *shop) {
+    static OutBuf ob;
+    SlateColumns sc;
+    GameContext games = {0};
+    PlayerContext players = {0};
+    OutputSoA res = {0};
+    LinePrice *prices = NULL;
+    SimSummary *summary = NULL;
+    ShopQuotes quotes = {0};
+    ShopPick *picks = NULL;
+    double *consensus = NULL;
+    InputsSoA shop_cols;
+    uint8_t *draws = NULL;
+    ThreadPool *pool = NULL;
+    int rc = 1;
+
+    if (slate_columns_open(&sc, path, form) != 0) goto done;
+    const InputsSoA *cols = sc.cols;
+    if (shop) {
+        /* Project from the consensus line; each book's line is scored after. */
+        if (shop_load(&quotes, shop, sc.cols) != 0) goto done;
+        if (!(consensus = malloc((sc.cols->n ? sc.cols->n : 1) * sizeof *consensus)) ||
+            !(picks = malloc((sc.cols->n ? sc.cols->n : 1) * sizeof *picks))) {
+            fprintf(stderr, "out of memory for %zu players\n", sc.cols->n);
+            goto done;
+        }
+        shop_consensus(&quotes, sc.cols, consensus);
+        shop_cols = *sc.cols;
+        shop_cols.line_ast = consensus;
+        cols = &shop_cols;
+    }
+    if (output_soa_alloc(&res, cols->n) != 0) {
+        fprintf(stderr, "out of memory for %zu players\n", cols->n);
+        goto done;
+    }
+    if (!(pool = pool_create(nthreads))) {
+        fprintf(stderr, "cannot start thread pool\n");
+        goto done;
+    }
+    if (factor || normalize || (sim && sim->teams)) {
+        if (slate_factor(cols, &games, &players) != 0) {
+            fprintf(stderr, "out of memory factoring %zu players\n", cols->n);
+            goto done;
+        }
+        size_t over = (normalize || (sim && sim->teams)) ? oversized_games(&games, &players) : 0;
+        if (over)
+            fprintf(stderr, "warning: %zu team-games have more than %d players; teams with "
+                    "identical lines are merged unless the slate has a team column\n",
+                    over, TEAM_ROSTER_MAX);
+    }
+    if (factor)
+        project_batch_factored(pool, &games, &players, &res);
+    else
+        project_batch_parallel(pool, cols, &res);
+    if (normalize && team_normalize(&games, &players, &res) != 0) {
+        fprintf(stderr, "out of memory normalizing %zu players\n", cols->n);
+        goto done;
+    }
+
+    ob.fd = 1;
+    if (sim) {
+        size_t n = cols->n;
+        int too_big = sim_out && n && sim->nsims > (SIZE_MAX - 1) / n;
+        summary = malloc((n ? n : 1) * sizeof *summary);
+        if (sim_out && !too_big) draws = malloc(n * sim->nsims + 1);
+        if (!summary || too_big || (sim_out && !draws)) {
+            fprintf(stderr, "out of memory simulating %zu players\n", n);
+            goto done;
+        }
+        if (sim->teams) {
+            if (simulate_slate_teams(pool, cols, &res, &players, games.n, sim, draws, summary) != 0) {
+                fprintf(stderr, "out of memory simulating %zu players by team\n", n);
+                goto done;
+            }
+        } else {
+            simulate_slate(pool, cols, &res, sim, draws, summary);
+        }
+        if (sim_out && write_sim_draws(sim_out, draws, n, sim->nsims) != 0) goto done;
+        write_sim_header(&ob, fmt);
+        for (size_t i = 0; i < n; ++i)
+            write_sim_row(&ob, fmt, strtab_name(cols->names, cols->player_id[i]), &summary[i]);
+    } else if (shop) {
+        size_t priced = 0;
+        shop_lines(pool, &res, &quotes, picks);
+        write_shop_header(&ob, fmt);
+        for (size_t i = 0; i < cols->n; ++i) {
+            if (quotes.start[i + 1] == quotes.start[i]) continue;
+            write_shop_row(&ob, fmt, strtab_name(cols->names, cols->player_id[i]),
+                           res.projection[i], consensus[i], &quotes, i, &picks[i]);
+            ++priced;
+        }
+        fprintf(stderr, "%zu players priced, %zu quotes at %u books, %zu players without quotes\n",
+                priced, quotes.n, quotes.books.count, cols->n - priced);
+    } else if (ladder) {
+        if (!(prices = malloc(cols->n * (size_t)ladder->n * sizeof *prices))) {
+            fprintf(stderr, "out of memory pricing %zu players\n", cols->n);
+            goto done;
+        }
+        price_ladder_batch(pool, &res, ladder, prices);
+        write_ladder_header(&ob, fmt);
+        for (size_t i = 0; i < cols->n; ++i) {
+            const char *name = strtab_name(cols->names, cols->player_id[i]);
+            for (int t = 0; t < ladder->n; ++t)
+                write_ladder_row(&ob, fmt, name, ladder->lines[t], &prices[i * (size_t)ladder->n + t]);
+        }
+    } else {
+        write_header(&ob, fmt, cols->n);
+        for (size_t i = 0; i < cols->n; ++i) {
+            Output o = output_row(&res, i);
+            write_row(&ob, fmt, i, strtab_name(cols->names, cols->player_id[i]), &o);
+        }
+    }
+    ob_flush(&ob);
+    rc = ob.failed ? 1 : 0;
+
+done:
+    pool_destroy(pool);
+    game_context_free(&games);
+    player_context_free(&players);
+    free(prices);
+    free(picks);
+    free(consensus);
+    shop_quotes_free(&quotes);
+    free(summary);
+    free(draws);
+    output_soa_free(&res);
+    slate_columns_close(&sc);
+    return rc;
+}
+
+/* Text slate -> .aslate, for sweeps that re-read the same slate. */
+static int run_convert(const char *in_path, const char *out_path, const FormStore *form) {
+    SlateColumns sc;
+    int rc = slate_columns_open(&sc, in_path, form) == 0 && aslate_write(out_path, sc.cols) == 0 ? 0 : 1;
+    slate_columns_close(&sc);
+    return rc;
+}
+
+/* Joins odds snapshots to the game-log features known at each one, and
+ * to the book's line at that time if a line store is given. */
+static int run_asof(const char *snap_path, const char *log_path, FormMode mode, double half_life,
+                    const char *lines_path, const char *book) {
+    static OutBuf ob;
+    FormStore store = {0};
+    LineStore lines;
+    uint32_t book_id = STRTAB_NONE;
+    size_t joined = 0, skipped = 0;
+    if (lines_path) {
+        if (line_store_open(&lines, lines_path) != 0) return 1;
+        if ((book_id = strtab_find(&lines.books, book)) == STRTAB_NONE) {
+            fprintf(stderr, "%s: no lines from book '%s'\n", lines_path, book);
+            line_store_close(&lines);
+            return 1;
+        }
+    }
+    form_store_set_half_life(&store, half_life > 0.0 ? half_life : FORM_HALF_LIFE);
+    store.mode = mode;
+    ob.fd = 1;
+    int rc = asof_join(snap_path, log_path, &store, lines_path ? &lines : NULL, book_id, &ob,
+                       &joined, &skipped);
+    ob_flush(&ob);
+    if (rc == 0)
+        fprintf(stderr, "%zu snapshots joined, %zu skipped (no earlier game%s), %u players\n",
+                joined, skipped, lines_path ? " or line" : "", store.names.count);
+    form_store_free(&store);
+    if (lines_path) line_store_close(&lines);
+    return rc == 0 && !ob.failed ? 0 : 1;
+}
+
+/* Appends a line-history CSV to a line store. */
+static int run_lines_append(const char *store_path, const char *csv_path) {
+    LineStore s;
+    size_t rows = 0;
+    if (line_store_open(&s, store_path) != 0) return 1;
+    int rc = line_store_append_csv(&s, store_path, csv_path, &rows);
+    if (rc == 0)
+        printf("%s: %zu rows appended, %llu points for %u players at %u books\n", store_path, rows,
+               (unsigned long long)s.npoints, s.players.count, s.books.count);
+    line_store_close(&s);
+    return rc == 0 ? 0 : 1;
+}
+
+/* Re-cuts a line store into full blocks. */
+static int run_lines_compact(const char *store_path) {
+    LineStore s;
+    if (line_store_open(&s, store_path) != 0) return 1;
+    uint64_t before = s.valid_end;
+    int rc = line_store_compact(&s, store_path);
+    if (rc == 0) {
+        struct stat st;
+        if (stat(store_path, &st) == 0)
+            printf("%s: %llu points, %llu -> %llu bytes\n", store_path, (unsigned long long)s.npoints,
+                   (unsigned long long)before, (unsigned long long)st.st_size);
+    }
+    line_store_close(&s);
+    return rc == 0 ? 0 : 1;
+}
+
+/* Size and shape of a line store. */
+static int run_lines_info(const char *store_path) {
+    LineStore s;
+    if (line_store_open(&s, store_path) != 0) return 1;
+    int64_t t0 = INT64_MAX, t1 = INT64_MIN;
+    for (size_t b = 0; b < s.nblocks; ++b) {
+        if (s.blocks[b].ts_min < t0) t0 = s.blocks[b].ts_min;
+        if (s.blocks[b].ts_max > t1) t1 = s.blocks[b].ts_max;
+    }
+    printf("players %u, books %u, blocks %zu, points %llu\n", s.players.count, s.books.count,
+           s.nblocks, (unsigned long long)s.npoints);
+    if (s.npoints)
+        printf("from %lld to %lld, %.2f bytes per point (%.2f payload)\n",
+               (long long)minutes_to_ts(t0), (long long)minutes_to_ts(t1),
+               (double)s.valid_end / (double)s.npoints, (double)s.payload_bytes / (double)s.npoints);
+    line_store_close(&s);
+    return 0;
+}
+
+/* Applies a night's game log to the saved form state. */
+static int run_form_update(const char *state_path, const char *log_path, double half_life) {
+    FormStore store;
+    size_t applied = 0, skipped = 0;
+    if (form_store_load(&store, state_path, half_life) != 0) return 1;
+    int rc = form_store_apply_log(&store, log_path, &applied, &skipped) == 0 &&
+             form_store_save(&store, state_path) == 0 ? 0 : 1;
+    if (rc == 0)
+        printf("%s: %zu games applied, %zu already seen, %u players\n",
+               state_path, applied, skipped, store.names.count);
+    form_store_free(&store);
+    return rc;
+}
+
+/* Historical rows: every slate column plus the assists actually recorded. */
+typedef struct {
+    Inputs in;
+    double actual_ast;
+} HistRow;
+
+static int history_load_csv(const char *path, Slate *slate, double **actual) {
+    CsvField fields[N_SLATE_FIELDS + 1];
+    for (size_t k = 0; k < N_SLATE_FIELDS; ++k) {
+        fields[k] = SLATE_FIELDS[k];
+        fields[k].offset += offsetof(HistRow, in);
+    }
+    fields[N_SLATE_FIELDS] = (CsvField){ "actual_ast", CSV_F64, offsetof(HistRow, actual_ast), 1 };
+
+    CsvReader r;
+    char namebuf[128];
+    if (csv_open(&r, path, fields, N_SLATE_FIELDS + 1, csv_name_scratch, namebuf) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return -1;
+    }
+    size_t cap = csv_rows_hint(&r);
+    *actual = malloc(cap * sizeof **actual);
+    if (!*actual || slate_reserve(slate, cap) != 0) {
+        fprintf(stderr, "out of memory sizing %s\n", path);
+        csv_close(&r);
+        return -1;
+    }
+    HistRow row;
+    int rc;
+    while ((rc = csv_next(&r, &row)) == 1) {
+        (*actual)[slate->n] = row.actual_ast;
+        if (slate_push(slate, &row.in) != 0) {
+            fprintf(stderr, "out of memory after %zu rows\n", slate->n);
+            rc = -1;
+            break;
+        }
+    }
+    if (rc < 0 && r.err[0]) fprintf(stderr, "%s: %s\n", path, r.err);
+    csv_close(&r);
+    return rc < 0 ? -1 : 0;
+}
+
+/* Loads a history CSV into columns plus its actual_ast column. */
+static int history_columns(const char *path, Slate *hist, double **actual, InputsSoA *cols) {
+    if (history_load_csv(path, hist, actual) != 0) return -1;
+    if (hist->n == 0) {
+        fprintf(stderr, "%s: no rows\n", path);
+        return -1;
+    }
+    if (inputs_soa_alloc(cols, hist->n) != 0) {
+        fprintf(stderr, "out of memory for %zu rows\n", hist->n);
+        return -1;
+    }
+    inputs_to_soa(hist->in, hist->n, &hist->names, cols);
+    return 0;
+}
+
+static int run_fit(const char *path, const FitOptions *opt, int nthreads) {
+    Slate hist = {0};
+    double *actual = NULL;
+    InputsSoA cols = {0};
+    ThreadPool *pool = NULL;
+    int rc = 1;
+
+    if (history_columns(path, &hist, &actual, &cols) != 0) goto done;
+    if (!(pool = pool_create(nthreads))) {
+        fprintf(stderr, "cannot start thread pool\n");
+        goto done;
+    }
+
+    Weights w = default_weights(), start = w;
+    double start_loss;
+    double loss = fit_weights(pool, &cols, actual, opt, &w, &start_loss);
+    if (loss < 0.0) { fprintf(stderr, "out of memory\n"); goto done; }
+
+    printf("rows %zu  loss %.6f -> %.6f\n", hist.n, start_loss, loss);
+    printf("%-12s %10s %10s\n", "param", "default", "fitted");
+    for (int j = 0; j < N_PARAMS; ++j)
+        printf("%-12s %10.4f %10.4f\n", PARAM_NAMES[j], weights_vec(&start)[j], weights_vec(&w)[j]);
+    printf("\n/* paste into WEIGHT_PROFILES */\n    X(fitted, ");
+    for (int j = 0; j < N_PARAMS; ++j)
+        printf("%.4f%s", weights_vec(&w)[j], j + 1 < N_PARAMS ? ", " : ")\n");
+    rc = 0;
+
+done:
+    pool_destroy(pool);
+    inputs_soa_free(&cols);
+    free(actual);
+    slate_free(&hist);
+    return rc;
+}
+
+static int run_sweep(const char *path, const SweepAxis *axes, int naxes,
+                     const SweepOptions *opt, int nthreads) {
+    static OutBuf ob;
+    Slate hist = {0};
+    double *actual = NULL;
+    InputsSoA cols = {0};
+    SweepCache cache = {0};
+    ThreadPool *pool = NULL;
+    int rc = 1;
+
+    if (history_columns(path, &hist, &actual, &cols) != 0) goto done;
+    if (!(pool = pool_create(nthreads))) {
+        fprintf(stderr, "cannot start thread pool\n");
+        goto done;
+    }
+    Weights start = default_weights(), best;
+    if (sweep_cache_build(&cache, &start, &cols, axes, naxes) != 0) {
+        fprintf(stderr, "out of memory caching %zu rows\n", cols.n);
+        goto done;
+    }
+
+    ob.fd = 1;
+    double loss = sweep_run(pool, &cache, actual, opt, &start, &best, &ob);
+    ob_flush(&ob);
+    if (loss < 0.0) { fprintf(stderr, "out of memory\n"); goto done; }
+    fprintf(stderr, "best loss %.6f at", loss);
+    for (int a = 0; a < naxes; ++a)
+        fprintf(stderr, " %s=%.6g", PARAM_NAMES[axes[a].param], weights_vec(&best)[axes[a].param]);
+    fprintf(stderr, "\n");
+    rc = ob.failed ? 1 : 0;
+
+done:
+    pool_destroy(pool);
+    sweep_cache_free(&cache);
+    inputs_soa_free(&cols);
+    free(actual);
+    slate_free(&hist);
+    return rc;
+}
+
+/* Backtest rows: slate columns, the outcome, and optional odds and season. */
+typedef struct {
+    Inputs in;
+    double actual_ast, over_odds, under_odds;
+    int season;
+} BtRow;
+
+static int run_backtest(const char *path, const BacktestOptions *opt, int nthreads) {
+    CsvField fields[N_SLATE_FIELDS + 4];
+    for (size_t k = 0; k < N_SLATE_FIELDS; ++k) {
+        fields[k] = SLATE_FIELDS[k];
+        fields[k].offset += offsetof(BtRow, in);
+    }
+    fields[N_SLATE_FIELDS]     = (CsvField){ "actual_ast", CSV_F64, offsetof(BtRow, actual_ast), 1 };
+    fields[N_SLATE_FIELDS + 1] = (CsvField){ "over_odds",  CSV_F64, offsetof(BtRow, over_odds), 0 };
+    fields[N_SLATE_FIELDS + 2] = (CsvField){ "under_odds", CSV_F64, offsetof(BtRow, under_odds), 0 };
+    fields[N_SLATE_FIELDS + 3] = (CsvField){ "season",     CSV_I32, offsetof(BtRow, season), 0 };
+
+    CsvReader r;
+    char namebuf[128];
+    if (csv_open(&r, path, fields, N_SLATE_FIELDS + 4, csv_name_scratch, namebuf) != 0) {
+        fprintf(stderr, "%s\n", r.err);
+        return 1;
+    }
+    static BtStats totals[BT_MAX_GROUPS];
+    int seasons[BT_MAX_GROUPS];
+    BtBlock blk;
+    Inputs *rows = malloc(BT_BLOCK * sizeof *rows);
+    BtJob job = { &blk, opt, 0, calloc(BT_BLOCK / BT_CHUNK * BT_MAX_GROUPS, sizeof(BtStats)) };
+    ThreadPool *pool = NULL;
+    int rc = -1;
+
+    if (bt_block_alloc(&blk) != 0 || !rows || !job.parts) {
+        fprintf(stderr, "out of memory\n");
+        goto done;
+    }
+    if (!(pool = pool_create(nthreads))) {
+        fprintf(stderr, "cannot start thread pool\n");
+        goto done;
+    }
+    do {
+        blk.n = 0;
+        BtRow row;
+        while (blk.n < BT_BLOCK) {
+            row.over_odds = row.under_odds = opt->odds;
+            row.season = 0;
+            if ((rc = csv_next(&r, &row)) != 1) break;
+            int g = 0;
+            while (g < job.ngroups && seasons[g] != row.season) ++g;
+            if (g == job.ngroups) {
+                if (g == BT_MAX_GROUPS) {
+                    snprintf(r.err, sizeof r.err, "more than %d seasons", BT_MAX_GROUPS);
+                    rc = -1;
+                    break;
+                }
+                seasons[job.ngroups++] = row.season;
+            }
+            row.in.player_id = 0;
+            row.in.team_id = STRTAB_NONE;
+            rows[blk.n] = row.in;
+            blk.actual[blk.n] = row.actual_ast;
+            blk.over_odds[blk.n] = row.over_odds;
+            blk.under_odds[blk.n] = row.under_odds;
+            blk.group[blk.n] = (uint16_t)g;
+            blk.n++;
+        }
+        if (rc < 0) break;
+        inputs_to_soa(rows, blk.n, NULL, &blk.in);
+        bt_run_block(pool, &job, totals);
+        csv_release(&r);
+    } while (rc == 1);
+
+    if (rc < 0) fprintf(stderr, "%s: %s\n", path, r.err);
+    else bt_report(totals, seasons, job.ngroups);
+
+done:
+    pool_destroy(pool);
+    free(job.parts);
+    free(rows);
+    bt_block_free(&blk);
+    csv_close(&r);
+    return rc < 0 ? 1 : 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s                       interactive, one player\n"
+            "       %s --batch [FILE] [opts]  project a whole slate (stdin if no FILE;\n"
+            "                                 FILE.csv is read by header, FILE.aslate is mapped)\n"
+            "       %s --convert IN OUT.aslate [--form STATE]  write a slate as a columnar .aslate file\n"
+            "       %s --form-update STATE LOG.csv [--half-life H]  apply a night's game logs\n"
+            "                                 to the form state (EWMA half-life H games, default 5)\n"
+            "       %s --asof SNAPS.csv LOG.csv  join odds snapshots to the form known at each ts\n"
+            "                                 (also --form-mode, --half-life); slate CSV on stdout;\n"
+            "                                 --lines STORE --book B takes the lines from a store\n"
+            "       %s --lines-append STORE CSV  append line/odds changes to a line store\n"
+            "       %s --lines-info STORE     size and shape of a line store\n"
+            "       %s --lines-compact STORE  re-cut a line store into full blocks\n"
+            "       %s --ndjson               stream JSON objects stdin -> projections stdout\n"
+            "       %s --fit FILE.csv [opts]  fit weights and caps to history (needs actual_ast)\n"
+            "       %s --sweep FILE.csv --axis NAME=LO:HI[:STEPS] ...  loss over a weight grid\n"
+            "       %s --backtest FILE.csv [opts]  score projections against outcomes\n"
+            "options:\n"
+            "  --kernel NAME   force avx512|avx2|sse2|scalar (default: widest supported)\n"
+            "  --threads N     worker threads (default: one per CPU)\n"
+            "  --profile NAME  run a compile-time folded weight profile (default|market|usage)\n"
+            "  --format FMT    csv|tsv|json|bin|explain (default: csv)\n"
+            "  --factor        compute team-game factors once per team-game\n"
+            "  --normalize     scale teams down to their team-total assist budget\n"
+            "  --form STATE    take the form columns from game-log state (--form-update)\n"
+            "  --form-mode M   window|ewma: last-10/last-5 windows or EWMA (default: window)\n"
+            "  --dispersion A  NB dispersion for p_over/p_under/p_push, 0 = Poisson (default: 0.05)\n"
+            "  --ladder L      price alternate lines instead: LO:HI[:STEP] or a,b,c (ascending)\n"
+            "  --sims N        simulate N outcomes per player and summarize them instead\n"
+            "  --sim-out FILE  also write the raw draws (ASIM binary)\n"
+            "  --teams         simulate teammates jointly from a shared team assist pool\n"
+            "  --seed S        simulation seed (default: 1)\n"
+            "  --shop QUOTES   score every book's line (CSV or .alines store) against one\n"
+            "                  projection from the median line; best over and under per player\n"
+            "  --at TS         with a store: each book's line as of yyyymmddHHMM (default: newest)\n"
+            "fit options:\n"
+            "  --loss L        mae|rmse|poisson|pinball[:TAU] (default: rmse)\n"
+            "  --iters N       optimizer steps (default: 300)\n"
+            "  --lr X          Adam step size (default: 0.01)\n"
+            "sweep options (also --loss, --threads):\n"
+            "  --axis A        NAME=LO:HI[:STEPS], NAME from the WEIGHT_PROFILES columns;\n"
+            "                  repeat to sweep the cartesian product\n"
+            "  --random N      sample N uniform points instead of the grid\n"
+            "  --seed S        seed for --random (default: 1)\n"
+            "backtest options (also --kernel, --profile, --threads):\n"
+            "  --edge X        bet only when |projection - line| > X (default: 0)\n"
+            "  --odds X        American odds for rows without over_odds/under_odds (default: -110)\n",
+            argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0);
+}
+
+static int run_interactive(void) {
+    Inputs in;
+    static char namebuf[128];
+
+    printf("Player name: ");
+    if (!fgets(namebuf, sizeof(namebuf), stdin)) return 0;
+    strip_newline(namebuf);
+    in.player_name = namebuf;
+
+    printf("Sportsbook line (assists): ");
+    scanf("%lf", &in.line_ast);
+
+    printf("Season avg assists: ");
+    scanf("%lf", &in.season_avg_ast);
+
+    printf("Is home? (1=yes, 0=no): ");
+    scanf("%d", &in.is_home);
+
+    printf("Game total O/U: ");
+    scanf("%lf", &in.game_total_ou);
+
+    printf("Team total O/U: ");
+    scanf("%lf", &in.team_total_ou);
+
+    printf("Opponent assists allowed per game: ");
+    scanf("%lf", &in.opp_ast_allowed);
+
+    printf("Projected matchup pace (possessions per team): ");
+    scanf("%lf", &in.matchup_pace);
+
+    printf("Recent avg assists (last N; enter season avg to neutralize): ");
+    scanf("%lf", &in.recent_avg_ast);
+
+    printf("Season avg minutes: ");
+    scanf("%lf", &in.season_avg_minutes);
+
+    printf("Expected minutes this game: ");
+    scanf("%lf", &in.expected_minutes);
+
+    printf("Back-to-back? (1=yes, 0=no): ");
+    scanf("%d", &in.is_back_to_back);
+
+    /* === Last-5 potential assists & conversion === */
+    printf("Last-5 average potential assists: ");
+    scanf("%lf", &in.last5_potential_ast);
+
+    printf("Last-5 conversion rate on potential assists (0–1, e.g., 0.54): ");
+    scanf("%lf", &in.last5_conversion);
+
+    Output out = project(&in);
+    print_output(&in, &out);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) return run_interactive();
+
+    const char *batch_file = NULL;
+    const char *fit_file = NULL;
+    FitOptions fit = { 300, 0.01, { LOSS_RMSE, 0.5 } };
+    const char *sweep_file = NULL;
+    SweepAxis axes[N_PARAMS];
+    int naxes = 0;
+    SweepOptions sweep = { { LOSS_RMSE, 0.5 }, 0, 1 };
+    const char *backtest_file = NULL;
+    BacktestOptions bt = { 0.0, -110.0 };
+    Ladder ladder = { .n = 0 };
+    SimOptions sim = { 0, 1, 0, 0 };
+    const char *sim_out = NULL;
+    const char *kernel = NULL;
+    const char *profile = NULL;
+    int batch = 0;
+    int nthreads = 0;
+    OutFormat fmt = OUT_CSV;
+    int factor = 0;
+    int normalize = 0;
+    const char *form_file = NULL;
+    FormMode form_mode = FORM_MODE_WINDOW;
+    double half_life = 0.0;
+    const char *convert_in = NULL, *convert_out = NULL;
+    const char *update_state = NULL, *update_log = NULL;
+    const char *asof_snaps = NULL, *asof_log = NULL;
+    const char *lines_file = NULL, *book = NULL;
+    ShopOptions shop = { NULL, 0 };
+
+    if (argc == 2 && strcmp(argv[1], "--ndjson") == 0) return run_ndjson(0, 1);
+    if (argc == 4 && strcmp(argv[1], "--lines-append") == 0) return run_lines_append(argv[2], argv[3]);
+    if (argc == 3 && strcmp(argv[1], "--lines-info") == 0) return run_lines_info(argv[2]);
+    if (argc == 3 && strcmp(argv[1], "--lines-compact") == 0) return run_lines_compact(argv[2]);
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            batch = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') batch_file = argv[++i];
+        } else if (strcmp(argv[i], "--fit") == 0 && i + 1 < argc) {
+            fit_file = argv[++i];
+        } else if (strcmp(argv[i], "--backtest") == 0 && i + 1 < argc) {
+            backtest_file = argv[++i];
+        } else if (strcmp(argv[i], "--edge") == 0 && i + 1 < argc) {
+            bt.edge = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--odds") == 0 && i + 1 < argc) {
+            bt.odds = atof(argv[++i]);
+            if (fabs(bt.odds) < 100.0) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep_file = argv[++i];
+        } else if (strcmp(argv[i], "--axis") == 0 && i + 1 < argc) {
+            if (naxes == N_PARAMS || parse_sweep_axis(argv[++i], &axes[naxes++]) != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            sweep.random = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            sweep.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            if (parse_loss(argv[++i], &fit.loss) != 0) { usage(argv[0]); return 2; }
+            sweep.loss = fit.loss;
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            fit.iters = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lr") == 0 && i + 1 < argc) {
+            fit.lr = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            kernel = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (parse_out_format(argv[++i], &fmt) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--dispersion") == 0 && i + 1 < argc) {
+            line_dispersion = atof(argv[++i]);
+            if (!(line_dispersion >= 0.0)) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--ladder") == 0 && i + 1 < argc) {
+            if (parse_ladder(argv[++i], &ladder) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--sims") == 0 && i + 1 < argc) {
+            sim.nsims = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--teams") == 0) {
+            sim.teams = 1;
+        } else if (strcmp(argv[i], "--sim-out") == 0 && i + 1 < argc) {
+            sim_out = argv[++i];
+        } else if (strcmp(argv[i], "--factor") == 0) {
+            factor = 1;
+        } else if (strcmp(argv[i], "--normalize") == 0) {
+            normalize = 1;
+        } else if (strcmp(argv[i], "--form") == 0 && i + 1 < argc) {
+            form_file = argv[++i];
+        } else if (strcmp(argv[i], "--form-mode") == 0 && i + 1 < argc) {
+            if (parse_form_mode(argv[++i], &form_mode) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--half-life") == 0 && i + 1 < argc) {
+            half_life = atof(argv[++i]);
+            if (!(half_life > 0.0)) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--convert") == 0 && i + 2 < argc) {
+            convert_in = argv[++i];
+            convert_out = argv[++i];
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines_file = argv[++i];
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            book = argv[++i];
+        } else if (strcmp(argv[i], "--shop") == 0 && i + 1 < argc) {
+            shop.path = argv[++i];
+        } else if (strcmp(argv[i], "--at") == 0 && i + 1 < argc) {
+            shop.at = strtoll(argv[++i], NULL, 10);
+            if (shop.at <= 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(argv[i], "--asof") == 0 && i + 2 < argc) {
+            asof_snaps = argv[++i];
+            asof_log = argv[++i];
+        } else if (strcmp(argv[i], "--form-update") == 0 && i + 2 < argc) {
+            update_state = argv[++i];
+            update_log = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (update_state) return run_form_update(update_state, update_log, half_life);
+    if (asof_snaps) {
+        if (!lines_file != !book) {
+            fprintf(stderr, "--lines and --book go together\n");
+            return 2;
+        }
+        return run_asof(asof_snaps, asof_log, form_mode, half_life, lines_file, book);
+    }
+    FormStore store;
+    if (form_file) {
+        if (form_store_load(&store, form_file, half_life) != 0) return 1;
+        store.mode = form_mode;
+    }
+    if (convert_in) {
+        int rc = run_convert(convert_in, convert_out, form_file ? &store : NULL);
+        if (form_file) form_store_free(&store);
+        return rc;
+    }
+    if (!batch && !fit_file && !sweep_file && !backtest_file) { usage(argv[0]); return 2; }
+    if (sweep_file && naxes == 0) {
+        fprintf(stderr, "--sweep needs at least one --axis\n");
+        return 2;
+    }
+
+    if (kernel_select(kernel) != 0) {
+        fprintf(stderr, "kernel '%s' is unknown or unsupported on this CPU\n", kernel);
+        return 2;
+    }
+    if (fit_file) return run_fit(fit_file, &fit, nthreads);
+    if (sweep_file) return run_sweep(sweep_file, axes, naxes, &sweep, nthreads);
+    if (profile && factor) {
+        fprintf(stderr, "--factor runs the default weights; it cannot be combined with --profile\n");
+        return 2;
+    }
+    if (profile && profile_select(profile) != 0) {
+        fprintf(stderr, "unknown weight profile '%s'\n", profile);
+        return 2;
+    }
+    if (backtest_file) return run_backtest(backtest_file, &bt, nthreads);
+
+    if ((ladder.n || sim.nsims || shop.path) && (fmt == OUT_BIN || fmt == OUT_EXPLAIN)) {
+        fprintf(stderr, "--ladder, --sims and --shop write csv, tsv or json\n");
+        return 2;
+    }
+    if (!!ladder.n + !!sim.nsims + !!shop.path > 1) {
+        fprintf(stderr, "--ladder, --sims and --shop are separate outputs; pick one\n");
+        return 2;
+    }
+    if (shop.at && !(shop.path && has_suffix(shop.path, ".alines"))) {
+        fprintf(stderr, "--at picks the time in a --shop line store\n");
+        return 2;
+    }
+    if ((sim_out || sim.teams) && !sim.nsims) {
+        fprintf(stderr, "--sim-out and --teams need --sims\n");
+        return 2;
+    }
+    sim.seed = sweep.seed;
+    int rc = run_batch(batch_file, form_file ? &store : NULL, nthreads, fmt, factor, normalize,
+                       ladder.n ? &ladder : NULL, sim.nsims ? &sim : NULL, sim_out,
+                       shop.path ? &shop : NULL);
+    if (form_file) form_store_free(&store);
+    return rc;
+}